@@ -0,0 +1,95 @@
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <iostream>
+
+#include "reflect.h"
+#include "serialize.h"
+#include "tuple.h"
+
+// From aggregate_initialization.cpp
+struct base1 { int b1, b2 = 42; };
+
+struct S
+{
+    int x;
+
+    struct Foo
+    {
+        int i = 2;
+        int j;
+        int a[3];
+    } b;
+};
+
+// A plain struct: no Fields(), no operator==, no std::hash
+struct trade{
+    std::uint64_t id;
+    std::string symbol;
+    double price;
+    int quantity;
+    S::Foo extra;
+};
+
+// Trivially copyable but padded: serialize.h packs it through reflection,
+// in 13 bytes rather than 24 with the padding
+struct quote{
+    char side;
+    double price;
+    int size;
+};
+
+// Padding-free: reflected too, and its fields add up to its size, so it
+// still packs as one memcpy
+struct vec2{
+    double x, y;
+};
+
+static_assert(binary::reflected<quote> && !binary::bitwise<quote>() && binary::fixed_size<quote>() == 13);
+static_assert(binary::reflected<vec2> && binary::bitwise<vec2>());
+
+static_assert(reflect::field_count<base1>() == 2);
+static_assert(reflect::field_count<S>() == 2);
+static_assert(reflect::field_count<S::Foo>() == 3);      // a[3] is one field
+static_assert(reflect::field_count<trade>() == 5);
+
+struct trade_hash{
+    std::size_t operator()(const trade& t) const {
+        return reflect::hash(t);
+    }
+};
+
+struct trade_equal{
+    bool operator()(const trade& a, const trade& b) const {
+        return reflect::equal(a, b);
+    }
+};
+
+int main(){
+    S s{1, {2, 3, {4, 5, 6}}};
+    auto fields = reflect::to_tuple(s);
+    Get<0>(fields) = 10;                 // references: writes through to s
+    std::cout << s.x << ' ' << Get<1>(fields).a[2] << '\n';
+
+    for (auto name : reflect::field_type_names<trade>()) std::cout << name << '\n';
+
+    trade a{1, "ACME", 101.5, 300, {2, 3, {4, 5, 6}}};
+    trade b = a;
+    b.extra.a[2] = 7;
+    std::cout << reflect::equal(a, a) << reflect::equal(a, b) << reflect::less(a, b) << reflect::less(b, a) << '\n';
+
+    std::unordered_set<trade, trade_hash, trade_equal> seen{a, b, a};
+    std::cout << seen.size() << '\n';
+
+    // serialize.h reflects aggregates it has no Fields() for
+    std::vector<std::byte> buf;
+    binary::pack(a, buf);
+    binary::view<trade> v{buf};
+    std::cout << buf.size() << ": " << Get<1>(v) << ' ' << Get<4>(v).a[1] << ' '
+              << reflect::equal(v.unpack(), a) << '\n';
+
+    buf.clear();
+    binary::pack(quote{'B', 99.5, 10}, buf);
+    std::cout << buf.size() << ": " << Get<1>(binary::view<quote>{buf}) << '\n';
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+// Monotonic (bump) allocator. Allocating is a pointer increment and
+// deallocating does nothing; everything is freed at once by reset().
+//
+// Unlike std::pmr::monotonic_buffer_resource, reset() keeps the memory
+// for the next round: if the last round needed several chunks they are
+// merged into one, so a steady request loop stops calling upstream.
+// Whatever was allocated from the arena (e.g. vectors using it) must be
+// destroyed before reset() or release().
+class arena_resource : public std::pmr::memory_resource{
+    public:
+        explicit arena_resource(std::size_t initial_size = 64 * 1024,
+                                std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+        arena_resource(const arena_resource&) = delete;
+        arena_resource& operator=(const arena_resource&) = delete;
+
+        ~arena_resource() override {
+            release();
+        }
+
+        // Starts over, keeping the memory
+        void reset();
+
+        // Gives all memory back to upstream
+        void release();
+
+        // Bytes reserved from upstream
+        std::size_t reserved() const {
+            return total;
+        }
+
+    private:
+        struct chunk{
+            chunk* next;
+            std::size_t size;
+        };
+
+        static constexpr std::size_t chunk_align = alignof(std::max_align_t);
+        static constexpr std::size_t header_size = (sizeof(chunk) + chunk_align - 1) / chunk_align * chunk_align;
+
+        void* do_allocate(std::size_t bytes, std::size_t align) override;
+
+        void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        void add_chunk(std::size_t min_bytes);
+
+        std::pmr::memory_resource* upstream;
+        chunk* head = nullptr;      // most recently added chunk
+        std::byte* cur = nullptr;
+        std::byte* end = nullptr;
+        std::size_t next_size;
+        std::size_t total = 0;
+};
+
+inline arena_resource::arena_resource(std::size_t initial_size, std::pmr::memory_resource* upstream)
+    : upstream(upstream), next_size(std::max(initial_size, header_size + chunk_align))
+{}
+
+inline void* arena_resource::do_allocate(std::size_t bytes, std::size_t align){
+    auto aligned = [&]{
+        auto addr = reinterpret_cast<std::uintptr_t>(cur);
+        return reinterpret_cast<std::byte*>((addr + align - 1) & ~(align - 1));
+    };
+
+    // Chunk ends aren't aligned, so aligning can step past the end
+    std::byte* q = aligned();
+    if (!cur || q > end || bytes > static_cast<std::size_t>(end - q)){
+        add_chunk(bytes + align);
+        q = aligned();
+    }
+
+    cur = q + bytes;
+    return q;
+}
+
+inline void arena_resource::add_chunk(std::size_t min_bytes){
+    std::size_t size = std::max(next_size, header_size + min_bytes);
+    void* mem = upstream->allocate(size, chunk_align);
+
+    head = new(mem) chunk{head, size};
+    cur = static_cast<std::byte*>(mem) + header_size;
+    end = static_cast<std::byte*>(mem) + size;
+    total += size;
+    next_size = size * 2;
+}
+
+inline void arena_resource::reset(){
+    if (!head) return;
+
+    if (head->next){
+        std::size_t size = total;
+        release();
+        next_size = size;
+        add_chunk(0);
+        return;
+    }
+
+    cur = reinterpret_cast<std::byte*>(head) + header_size;
+}
+
+inline void arena_resource::release(){
+    while (head){
+        chunk* next = head->next;
+        upstream->deallocate(head, head->size, chunk_align);
+        head = next;
+    }
+
+    cur = end = nullptr;
+    total = 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+
+// Keeps the compiler from optimizing away a value that is computed
+// only to be measured
+template<typename T>
+inline void do_not_optimize(const T& value){
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Best of `reps` runs of `f`, in milliseconds. Taking the minimum
+// filters out most of the noise from the scheduler and cold caches.
+template<typename F>
+double time_ms(F&& f, int reps = 5){
+    double best = 0;
+    for (int r=0;r<reps;++r){
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto stop = std::chrono::steady_clock::now();
+
+        double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+        if (r == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+inline void report(std::string_view name, double ms){
+    std::cout << std::left << std::setw(32) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(2)
+              << ms << " ms\n";
+}
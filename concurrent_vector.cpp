@@ -0,0 +1,253 @@
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <iostream>
+
+#include "bench.h"
+#include "vector.h"
+
+// Append-only vector that many threads can push_back into at once.
+//
+// Storage is a list of segments where segment k holds B * 2^k elements,
+// so elements never move once written (references stay valid) and the
+// list never has to be reallocated. push_back claims an index with a
+// single fetch_add, installs the segment with one CAS if it is the first
+// one there (the loser of that race frees its copy), constructs the
+// element and then marks it published. No step waits on another thread.
+// The push that reaches the middle of a segment installs the next one,
+// so that race, and the wasted copy, are rare.
+//
+// size() counts claimed slots. An element may only be read once it is
+// published: by the thread that pushed it, by anyone who was handed its
+// index after push_back returned, or through published()/for_each.
+template<typename T, std::size_t FirstSegmentLog = 5>
+class concurrent_vector{
+    public:
+        concurrent_vector() = default;
+
+        concurrent_vector(const concurrent_vector&) = delete;
+        concurrent_vector& operator=(const concurrent_vector&) = delete;
+
+        ~concurrent_vector();
+
+        // Returns the index of the new element
+        template<typename... Args>
+        std::size_t emplace_back(Args&&... args);
+
+        std::size_t push_back(const T& x){
+            return emplace_back(x);
+        }
+
+        std::size_t push_back(T&& x){
+            return emplace_back(std::move(x));
+        }
+
+        std::size_t size() const {
+            return std::min(sz.load(std::memory_order_acquire), max_size);
+        }
+
+        bool published(std::size_t i) const;
+
+        T& operator[](std::size_t i){
+            return *locate(i).value();
+        }
+
+        const T& operator[](std::size_t i) const {
+            return *locate(i).value();
+        }
+
+        // Calls f on every published element, in index order
+        template<typename F>
+        void for_each(F f) const;
+
+    private:
+        // Trivial, so zeroed memory from calloc is already an array of
+        // unpublished slots. ready is only accessed through flag().
+        struct slot{
+            alignas(std::atomic_ref<bool>::required_alignment) bool ready;
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            std::atomic_ref<bool> flag(){
+                return std::atomic_ref<bool>{ready};
+            }
+
+            T* value(){
+                return std::launder(reinterpret_cast<T*>(storage));
+            }
+
+            const T* value() const {
+                return std::launder(reinterpret_cast<const T*>(storage));
+            }
+        };
+
+        static constexpr std::size_t first_segment_size = std::size_t{1} << FirstSegmentLog;
+        static constexpr std::size_t max_segments = 64 - FirstSegmentLog;
+        static constexpr std::size_t max_size = ~std::size_t{0} - first_segment_size + 1;
+
+        static constexpr std::size_t segment_size(std::size_t k){
+            return first_segment_size << k;
+        }
+
+        // Segment and offset of element i: shifting i by the first
+        // segment's size makes the segment number a bit_width
+        static constexpr std::size_t segment_of(std::size_t i){
+            return std::bit_width(i + first_segment_size) - 1 - FirstSegmentLog;
+        }
+
+        static constexpr std::size_t offset_of(std::size_t i, std::size_t k){
+            return i + first_segment_size - segment_size(k);
+        }
+
+        slot& locate(std::size_t i) const {
+            std::size_t k = segment_of(i);
+            return segments[k].load(std::memory_order_acquire)[offset_of(i, k)];
+        }
+
+        slot* get_segment(std::size_t k);
+
+        std::atomic<std::size_t> sz{0};
+        mutable std::array<std::atomic<slot*>, max_segments> segments{};
+};
+
+template<typename T, std::size_t FirstSegmentLog>
+concurrent_vector<T, FirstSegmentLog>::~concurrent_vector(){
+    for (std::size_t k=0;k<max_segments;++k){
+        slot* seg = segments[k].load(std::memory_order_relaxed);
+        if (!seg) continue;
+
+        if constexpr (!std::is_trivially_destructible_v<T>){      // else skip a pass over every slot
+            for (std::size_t j=0;j<segment_size(k);++j){
+                if (seg[j].flag().load(std::memory_order_relaxed)) seg[j].value()->~T();
+            }
+        }
+        std::free(seg);
+    }
+}
+
+template<typename T, std::size_t FirstSegmentLog>
+typename concurrent_vector<T, FirstSegmentLog>::slot* concurrent_vector<T, FirstSegmentLog>::get_segment(std::size_t k){
+    static_assert(std::is_trivial_v<slot> && std::atomic_ref<bool>::is_always_lock_free);
+
+    slot* seg = segments[k].load(std::memory_order_acquire);
+    if (seg) return seg;
+
+    // calloc gets fresh pages from the OS without touching them, so the
+    // slots aren't swept once here and again when written
+    slot* fresh = static_cast<slot*>(std::calloc(segment_size(k), sizeof(slot)));
+    if (!fresh) throw std::bad_alloc{};
+    if (segments[k].compare_exchange_strong(seg, fresh, std::memory_order_acq_rel)){
+        return fresh;
+    }
+
+    std::free(fresh);       // another thread got there first
+    return seg;
+}
+
+template<typename T, std::size_t FirstSegmentLog>
+template<typename... Args>
+std::size_t concurrent_vector<T, FirstSegmentLog>::emplace_back(Args&&... args){
+    std::size_t i = sz.fetch_add(1, std::memory_order_relaxed);
+    if (i >= max_size) throw std::bad_alloc{};
+
+    std::size_t k = segment_of(i);
+    std::size_t j = offset_of(i, k);
+    slot& s = get_segment(k)[j];
+
+    new(s.storage) T(std::forward<Args>(args)...);
+    s.flag().store(true, std::memory_order_release);
+
+    // Half way through segment k, install k+1 before anyone needs it
+    if (j == segment_size(k) / 2 && k + 1 < max_segments){
+        try {
+            get_segment(k + 1);
+        }
+        catch (const std::bad_alloc&){}     // retried when it is needed
+    }
+    return i;
+}
+
+template<typename T, std::size_t FirstSegmentLog>
+bool concurrent_vector<T, FirstSegmentLog>::published(std::size_t i) const {
+    if (i >= size()) return false;
+
+    std::size_t k = segment_of(i);
+    slot* seg = segments[k].load(std::memory_order_acquire);
+    return seg && seg[offset_of(i, k)].flag().load(std::memory_order_acquire);
+}
+
+template<typename T, std::size_t FirstSegmentLog>
+template<typename F>
+void concurrent_vector<T, FirstSegmentLog>::for_each(F f) const {
+    std::size_t n = size();
+    for (std::size_t i=0;i<n;++i){
+        if (published(i)) f(*locate(i).value());
+    }
+}
+
+// What we are replacing: a vector behind a mutex
+template<typename T>
+class locked_vector{
+    public:
+        void push_back(const T& x){
+            std::lock_guard lock{m};
+            v.push_back(x);
+        }
+
+        std::size_t size(){
+            std::lock_guard lock{m};
+            return v.size();
+        }
+
+    private:
+        std::mutex m;
+        vector<T> v{0};
+};
+
+// `threads` threads push `total` ints between them
+template<typename Container>
+double bench_append(unsigned threads, std::size_t total){
+    return time_ms([&]{
+        Container c;
+        std::vector<std::thread> pool;
+        for (unsigned t=0;t<threads;++t){
+            pool.emplace_back([&, t]{
+                for (std::size_t i=t;i<total;i+=threads) c.push_back(int(i));
+            });
+        }
+        for (auto& th : pool) th.join();
+        do_not_optimize(c.size());
+    }, 3);
+}
+
+int main(){
+    concurrent_vector<int> v;
+    std::vector<std::thread> producers;
+    for (int t=0;t<4;++t){
+        producers.emplace_back([&v, t]{
+            for (int i=0;i<1000;++i) v.push_back(t * 1000 + i);
+        });
+    }
+
+    const int& first = v[v.push_back(-1)];      // stays valid while others append
+    for (auto& th : producers) th.join();
+
+    long long sum = 0;
+    v.for_each([&](int x){ sum += x; });
+    std::cout << v.size() << ' ' << sum << ' ' << first << '\n';
+
+    constexpr std::size_t total = 1 << 24;
+    unsigned max_threads = std::max(4u, std::thread::hardware_concurrency());
+    std::cout << "\n" << total << " appends\n";
+    for (unsigned threads=1;threads<=max_threads;threads*=2){
+        std::cout << threads << " thread(s)\n";
+        report("  mutex + vector", bench_append<locked_vector<int>>(threads, total));
+        report("  concurrent_vector", bench_append<concurrent_vector<int>>(threads, total));
+    }
+}
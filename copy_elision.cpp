@@ -1,26 +1,15 @@
+#define LIFECYCLE_COUNTERS
+
+#include <cassert>
+#include <thread>
+#include <type_traits>
+#include <vector>
 #include <iostream>
 
-class A{
-    public:
-        A(){ std::cout << "Constructor called!\n"; }
-        A(const A& a){ 
-            std::cout << "Copy constructor called!\n";
-        }
-        A(A&& a){
-            std::cout << "Move constructor called!\n";
-        }
-        A& operator=(A&& a){
-            std::cout << "Move assignment operator called!\n";
-            return *this;
-        }
-        A& operator=(const A& a){
-            std::cout << "Copy assignment operator called!\n";
-            return *this;
-        }
-        ~A(){
-            std::cout << "Destructor called!\n";
-        }
-};
+#include "lifecycle.h"
+
+// Counts its special member calls instead of printing them
+class A : public lifecycle::counted<A> {};
 
 A foo(){
     A a;
@@ -37,13 +26,48 @@ A loo(){
     return A{};
 }
 
-int main(){ 
-    A a = foo();    // move constructor elided
-    A b = goo();    // move constructor elided 
-    A c = A{};       // move elided
-    A d = A{A{A{}}};   // copy and move both elided
-                       // multiple elision
-    hoo({});    // constructor is called
-    hoo(A{});   // copy elided
-    loo();
-}
\ No newline at end of file
+// What happened to A objects while f ran
+template<typename F>
+lifecycle::counts count(F f){
+    auto before = lifecycle::snapshot<A>();
+    f();
+    return lifecycle::snapshot<A>() - before;
+}
+
+// Switched off, the counter is an empty base that changes nothing
+struct plain { int x; };
+struct quiet : lifecycle::counted<quiet, false> { int x; };
+static_assert(sizeof(quiet) == sizeof(plain) && std::is_trivially_copyable_v<quiet>);
+
+int main(){
+    auto nrvo = count([]{ A a = foo(); });      // move constructor elided
+    auto prvalue = count([]{
+        A b = goo();        // move constructor elided
+        A c = A{};          // move elided
+        A d = A{A{A{}}};    // copy and move both elided
+                            // multiple elision
+        hoo(A{});           // copy elided
+        loo();
+    });
+    auto param = count([]{ hoo({}); });         // constructor is called
+    std::cout << nrvo << '\n' << prvalue << '\n' << param << '\n';
+
+    assert(nrvo.copied == 0);                   // NRVO isn't guaranteed, but must not copy
+    assert(prvalue.copied == 0 && prvalue.moved == 0 && prvalue.constructed == 5);
+    assert(param.constructed == 1 && param.alive() == 0);
+
+    // Counts from several threads add up
+    auto threads = count([]{
+        std::vector<std::thread> pool;
+        for (int t=0;t<4;++t){
+            pool.emplace_back([]{
+                std::vector<A> v(1000);
+                auto w = v;
+                w = std::move(v);
+            });
+        }
+        for (auto& th : pool) th.join();
+    });
+    std::cout << threads << '\n';
+    assert(threads.copied == 4000 && threads.alive() == 0);
+}
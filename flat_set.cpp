@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <set>
+#include <utility>
+#include <iostream>
+
+#include "bench.h"
+#include "functors.h"
+#include "vector.h"
+
+// A set kept as a sorted array. Lookups are a binary search over
+// contiguous memory and iteration is a linear scan, where std::set chases
+// a pointer per step and spends a heap node per element.
+//
+// Single inserts and erases shift the tail, so a set is best filled in
+// batches with insert_many, which sorts the new keys and merges them in
+// one pass. Like std::set, a key equivalent to one already there is
+// dropped, and Compare can be a functor or a lambda.
+template<typename Key, typename Compare = std::less<Key>>
+class flat_set{
+    public:
+        using iterator = const Key*;
+
+        explicit flat_set(Compare comp = Compare{})
+            : comp(comp)
+        {}
+
+        std::pair<iterator, bool> insert(const Key& key);
+
+        // Appends, sorts the new keys, merges them in and drops duplicates
+        template<std::input_iterator It>
+        void insert_many(It first, It last);
+
+        bool erase(const Key& key);
+
+        iterator lower_bound(const Key& key) const {
+            return std::lower_bound(begin(), end(), key, comp);
+        }
+
+        iterator upper_bound(const Key& key) const {
+            return std::upper_bound(begin(), end(), key, comp);
+        }
+
+        iterator find(const Key& key) const {
+            iterator it = lower_bound(key);
+            return it != end() && !comp(key, *it) ? it : end();
+        }
+
+        bool contains(const Key& key) const {
+            return find(key) != end();
+        }
+
+        void reserve(std::size_t n){
+            keys.reserve(n);
+        }
+
+        void clear(){
+            keys.clear();
+        }
+
+        std::size_t size() const {
+            return keys.size();
+        }
+
+        bool empty() const {
+            return keys.empty();
+        }
+
+        iterator begin() const {
+            return keys.begin();
+        }
+
+        iterator end() const {
+            return keys.end();
+        }
+
+    private:
+        bool equivalent(const Key& a, const Key& b) const {
+            return !comp(a, b) && !comp(b, a);
+        }
+
+        vector<Key> keys{0};
+        [[no_unique_address]] Compare comp;
+};
+
+template<typename Key, typename Compare>
+std::pair<typename flat_set<Key, Compare>::iterator, bool> flat_set<Key, Compare>::insert(const Key& key){
+    std::size_t pos = lower_bound(key) - begin();
+    if (pos < keys.size() && !comp(key, keys[pos])) return {begin() + pos, false};
+
+    keys.insert(pos, &key, &key + 1);
+    return {begin() + pos, true};
+}
+
+// Keys already in the set come first in the merge, so they are the ones
+// that survive dedup
+template<typename Key, typename Compare>
+template<std::input_iterator It>
+void flat_set<Key, Compare>::insert_many(It first, It last){
+    std::size_t old_size = keys.size();
+    keys.append(first, last);
+
+    Key* mid = keys.data() + old_size;
+    std::sort(mid, keys.end(), comp);
+    std::inplace_merge(keys.begin(), mid, keys.end(), comp);
+
+    auto same = [this](const Key& a, const Key& b){ return equivalent(a, b); };
+    keys.resize(std::unique(keys.begin(), keys.end(), same) - keys.begin());
+}
+
+template<typename Key, typename Compare>
+bool flat_set<Key, Compare>::erase(const Key& key){
+    iterator it = find(key);
+    if (it == end()) return false;
+
+    std::move(keys.begin() + (it - begin()) + 1, keys.end(), keys.begin() + (it - begin()));
+    keys.pop_back();
+    return true;
+}
+
+int main(){
+    auto comp = [](const data& first, const data& second){
+        if (first.x != second.x) return first.x < second.x;
+        return first.y > second.y;
+    };
+    flat_set<data, decltype(comp)> s1(comp);
+    flat_set<data, Functor> s2;
+
+    for (int i=0;i<2;i++){
+        for (int j=2;j>0;j--){
+            s1.insert({i, j});
+        }
+    }
+    data batch[] = {{1, 1}, {0, 2}, {1, 2}, {0, 1}, {1, 2}};
+    s2.insert_many(std::begin(batch), std::end(batch));
+
+    for (const auto& d : s1) std::cout << "(" << d.x << ", " << d.y << "), ";
+    std::cout << '\n';
+    for (const auto& d : s2) std::cout << "(" << d.x << ", " << d.y << "), ";
+    std::cout << '\n' << s2.size() << ' ' << s2.contains({1, 1}) << ' ' << s2.erase({1, 1}) << ' ' << s2.contains({1, 1}) << '\n';
+
+    // Benchmark: 1M random records, then 1M lookups of which half hit
+    constexpr std::size_t n = 1 << 20;
+    std::mt19937 gen{42};
+    std::vector<data> records(n), probes(n);
+    for (auto& d : records) d = {int(gen() % (n / 4)), int(gen() % 64)};
+    for (std::size_t i=0;i<n;++i) probes[i] = i % 2 ? records[gen() % n] : data{int(gen() % (n / 4)), 64 + int(i % 7)};
+
+    std::set<data, Functor> tree;
+    flat_set<data, Functor> flat;
+    std::cout << "\n" << n << " records\n";
+    report("std::set insert", time_ms([&]{
+        tree.clear();
+        for (const auto& d : records) tree.insert(d);
+    }, 3));
+    report("flat_set insert_many", time_ms([&]{
+        flat.clear();
+        flat.insert_many(records.begin(), records.end());
+    }, 3));
+
+    report("std::set find", time_ms([&]{
+        std::size_t hits = 0;
+        for (const auto& d : probes) hits += tree.find(d) != tree.end();
+        do_not_optimize(hits);
+    }));
+    report("flat_set find", time_ms([&]{
+        std::size_t hits = 0;
+        for (const auto& d : probes) hits += flat.contains(d);
+        do_not_optimize(hits);
+    }));
+
+    report("std::set iterate", time_ms([&]{
+        long long s = 0;
+        for (const auto& d : tree) s += d.x;
+        do_not_optimize(s);
+    }));
+    report("flat_set iterate", time_ms([&]{
+        long long s = 0;
+        for (const auto& d : flat) s += d.x;
+        do_not_optimize(s);
+    }));
+
+    // A red-black node is three pointers and a color ahead of the key,
+    // rounded up by malloc; the flat set is just the keys
+    std::size_t node_bytes = (4 * sizeof(void*) + sizeof(data) + 15) / 16 * 16;
+    std::cout << "  " << tree.size() << " keys: std::set ~" << (tree.size() * node_bytes >> 20)
+              << " MB, flat_set " << (flat.size() * sizeof(data) >> 20) << " MB\n";
+}
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+#include "bench.h"
+#include "fork_join.h"
+
+int main(){
+    // The recursive lambdas call fork/join and don't know whether they
+    // run in a scheduler: outside run() they are plain serial recursion
+    auto fib = [](auto& self, int n) -> long long {
+        if (n < 2) return n;
+        if (n < 20) return self(self, n - 1) + self(self, n - 2);
+
+        auto t = fork_join::fork([&]{ return self(self, n - 1); });
+        long long b = self(self, n - 2);
+        return t.join() + b;
+    };
+
+    std::vector<long long> v(1 << 26);
+    std::iota(v.begin(), v.end(), 0);
+    auto sum = [&](auto& self, std::size_t b, std::size_t e) -> long long {
+        if (e - b <= 1024) return std::accumulate(v.begin() + b, v.begin() + e, 0LL);
+
+        long long left, right;
+        std::size_t mid = b + (e - b) / 2;
+        fork_join::join(e - b, [&]{ left = self(self, b, mid); },
+                               [&]{ right = self(self, mid, e); });
+        return left + right;
+    };
+
+    std::vector<int> keys(10'000'000);
+    auto quicksort = [&](auto& self, int* first, int* last) -> void {
+        std::size_t n = last - first;
+        if (n <= 32){
+            std::sort(first, last);
+            return;
+        }
+        int pivot = std::max(std::min(first[0], first[n / 2]), std::min(std::max(first[0], first[n / 2]), last[-1]));
+        int* lo = std::partition(first, last, [&](int x){ return x < pivot; });
+        int* hi = std::partition(lo, last, [&](int x){ return x == pivot; });
+        fork_join::join(n, [&]{ self(self, first, lo); }, [&]{ self(self, hi, last); });
+    };
+
+    // Exceptions from a stolen task come out of join()
+    fork_join::scheduler pool{4};
+    try {
+        pool.run([]{
+            auto t = fork_join::fork([]() -> int { throw std::runtime_error{"from a task"}; });
+            return t.join();
+        });
+    }
+    catch (const std::exception& e){
+        std::cout << "caught: " << e.what() << '\n';
+    }
+    std::cout << fib(fib, 30) << ' ' << pool.run([&]{ return fib(fib, 30); }) << '\n';
+
+    // Benchmark: each computation called directly (serial), then in
+    // schedulers of one thread and of every hardware thread
+    unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<unsigned> thread_counts{1};
+    if (cores > 1) thread_counts.push_back(cores);
+    std::mt19937 gen{42};
+    auto bench = [&](const char* name, auto f, auto check){
+        report(std::string(name) + " serial", time_ms([&]{ check(f()); }, 3));
+        for (unsigned threads : thread_counts){
+            fork_join::scheduler s{threads};
+            report(std::string(name) + ", " + std::to_string(threads) + " threads", time_ms([&]{ check(s.run(f)); }, 3));
+        }
+    };
+
+    std::cout << '\n' << cores << " hardware threads\n";
+    bench("fib(36)", [&]{ return fib(fib, 36); }, [](long long r){
+        if (r != 14930352) throw std::logic_error{"wrong fib"};
+    });
+    bench("sum of 64M", [&]{ return sum(sum, 0, v.size()); }, [&](long long r){
+        if (r != static_cast<long long>(v.size() * (v.size() - 1) / 2)) throw std::logic_error{"wrong sum"};
+    });
+    bench("quicksort 10M", [&]{
+        for (auto& k : keys) k = static_cast<int>(gen());
+        quicksort(quicksort, keys.data(), keys.data() + keys.size());
+        return 0;
+    }, [&](int){
+        if (!std::is_sorted(keys.begin(), keys.end())) throw std::logic_error{"not sorted"};
+    });
+}
@@ -0,0 +1,374 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Fork-join parallelism for recursive divide and conquer, such as the
+// self-passing lambdas (`dfs(u, dfs)`):
+//
+//     auto sum = [&](auto& self, std::size_t b, std::size_t e) -> long long {
+//         if (e - b == 1) return v[b];
+//         long long left, right;
+//         std::size_t mid = b + (e - b) / 2;
+//         fork_join::join(e - b, [&]{ left = self(self, b, mid); },
+//                                [&]{ right = self(self, mid, e); });
+//         return left + right;
+//     };
+//     fork_join::scheduler::global().run([&]{ return sum(sum, 0, v.size()); });
+//
+// fork(f) makes a task of f that an idle thread may take, and task.join()
+// waits for it, running other tasks in the meantime. Outside run() the
+// same code is serial: fork() defers f and join() calls it.
+//
+// Each thread keeps the tasks it forks in its own Chase-Lev deque. The
+// owner pushes and pops at the bottom without locking; idle threads
+// steal from the top, so they take the oldest and usually biggest
+// sub-problems. Task objects live in the forking frame, with no
+// allocation per fork, and must be joined by the thread that forked them.
+namespace fork_join
+{
+
+    class scheduler;
+
+    namespace detail
+    {
+
+        struct task_base{
+            virtual void execute() = 0;
+
+            std::atomic<bool> done{false};
+            std::exception_ptr error;
+
+            protected:
+                ~task_base() = default;
+        };
+
+        // Chase-Lev work-stealing deque (Lê et al., "Correct and Efficient
+        // Work-Stealing for Weak Memory Models", 2013), with seq_cst
+        // operations in place of the paper's fences. Only the owner
+        // calls push and pop.
+        class deque{
+            public:
+                explicit deque(std::size_t capacity = 256){
+                    rings.push_back(std::make_unique<ring>(capacity));
+                    buffer.store(rings.back().get(), std::memory_order_relaxed);
+                }
+
+                void push(task_base* t){
+                    std::int64_t b = bottom.load(std::memory_order_relaxed);
+                    std::int64_t tp = top.load(std::memory_order_acquire);
+                    ring* r = buffer.load(std::memory_order_relaxed);
+                    if (b - tp >= static_cast<std::int64_t>(r->capacity())) r = grow(r, tp, b);
+
+                    r->put(b, t);
+                    bottom.store(b + 1, std::memory_order_release);
+                }
+
+                // Newest task, or nullptr when empty
+                task_base* pop(){
+                    std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+                    ring* r = buffer.load(std::memory_order_relaxed);
+                    bottom.store(b, std::memory_order_seq_cst);
+                    std::int64_t t = top.load(std::memory_order_seq_cst);
+
+                    if (t > b){
+                        bottom.store(b + 1, std::memory_order_release);
+                        return nullptr;
+                    }
+                    task_base* x = r->get(b);
+                    if (t == b){
+                        // The last task: race the thieves for it
+                        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) x = nullptr;
+                        bottom.store(b + 1, std::memory_order_release);
+                    }
+                    return x;
+                }
+
+                // Oldest task, or nullptr when empty or lost to another thief
+                task_base* steal(){
+                    std::int64_t t = top.load(std::memory_order_seq_cst);
+                    std::int64_t b = bottom.load(std::memory_order_seq_cst);
+                    if (t >= b) return nullptr;
+
+                    task_base* x = buffer.load(std::memory_order_acquire)->get(t);
+                    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+                    return x;
+                }
+
+            private:
+                class ring{
+                    public:
+                        explicit ring(std::size_t capacity)
+                            : mask(capacity - 1), slots(new std::atomic<task_base*>[capacity])
+                        {}
+
+                        std::size_t capacity() const {
+                            return mask + 1;
+                        }
+
+                        task_base* get(std::int64_t i) const {
+                            return slots[static_cast<std::size_t>(i) & mask].load(std::memory_order_relaxed);
+                        }
+
+                        void put(std::int64_t i, task_base* t){
+                            slots[static_cast<std::size_t>(i) & mask].store(t, std::memory_order_relaxed);
+                        }
+
+                    private:
+                        std::size_t mask;
+                        std::unique_ptr<std::atomic<task_base*>[]> slots;
+                };
+
+                ring* grow(ring* r, std::int64_t t, std::int64_t b){
+                    auto bigger = std::make_unique<ring>(2 * r->capacity());
+                    for (std::int64_t i=t;i<b;++i) bigger->put(i, r->get(i));
+
+                    rings.push_back(std::move(bigger));
+                    buffer.store(rings.back().get(), std::memory_order_release);
+                    return rings.back().get();
+                }
+
+                alignas(64) std::atomic<std::int64_t> top{0};
+                alignas(64) std::atomic<std::int64_t> bottom{0};
+                std::atomic<ring*> buffer;
+                std::vector<std::unique_ptr<ring>> rings;   // outgrown ones too: a thief may still read them
+        };
+
+        // The scheduler this thread works for, if any, and its deque
+        struct worker{
+            scheduler* pool = nullptr;
+            std::size_t index = 0;
+        };
+
+        inline thread_local worker this_worker;
+
+    } // namespace detail
+
+    // Worker threads that steal forked tasks while some thread is inside
+    // run(). The thread calling run() takes part as worker 0.
+    class scheduler{
+        public:
+            explicit scheduler(unsigned threads = std::thread::hardware_concurrency());
+
+            scheduler(const scheduler&) = delete;
+            scheduler& operator=(const scheduler&) = delete;
+
+            ~scheduler();
+
+            // Threads taking part in run(), the caller included
+            unsigned size() const {
+                return static_cast<unsigned>(deques.size());
+            }
+
+            // Calls f() with the workers stealing the tasks it forks and
+            // returns its result. Calls from inside run() just call f().
+            template<typename F>
+            std::invoke_result_t<F&> run(F f);
+
+            static scheduler& global(){
+                static scheduler pool;
+                return pool;
+            }
+
+        private:
+            template<typename F>
+            friend class task;
+
+            void push(detail::task_base& t){
+                deques[detail::this_worker.index]->push(&t);
+            }
+
+            void wait(detail::task_base& t);
+            detail::task_base* steal(std::size_t thief);
+            void work(std::size_t index);
+
+            std::vector<std::unique_ptr<detail::deque>> deques;
+            std::vector<std::thread> workers;
+
+            std::mutex run_mutex;               // one run() at a time
+            std::mutex m;
+            std::condition_variable start_cv;
+            std::atomic<bool> busy{false};
+            bool stopping = false;
+    };
+
+    // f forked off; join() gives f's result, or rethrows what it threw.
+    // Made by fork(), and neither copyable nor movable since the deque
+    // points to it. One not joined is waited for when it goes out of scope.
+    template<typename F>
+    class task final : public detail::task_base{
+        public:
+            using result_type = std::invoke_result_t<F&>;
+
+            explicit task(F f)
+                : f(std::move(f)), pool(detail::this_worker.pool)
+            {
+                if (pool) pool->push(*this);
+            }
+
+            task(const task&) = delete;
+            task& operator=(const task&) = delete;
+
+            ~task(){
+                wait();
+            }
+
+            result_type join(){
+                wait();
+                if (error) std::rethrow_exception(error);
+                if constexpr (!std::is_void_v<result_type>) return std::move(*result);
+            }
+
+        private:
+            using stored = std::conditional_t<std::is_void_v<result_type>, bool, result_type>;
+
+            void execute() override {
+                try {
+                    if constexpr (std::is_void_v<result_type>) f();
+                    else result.emplace(f());
+                }
+                catch (...){
+                    error = std::current_exception();
+                }
+                done.store(true, std::memory_order_release);
+            }
+
+            void wait(){
+                if (done.load(std::memory_order_acquire)) return;
+                if (pool) pool->wait(*this);
+                else execute();
+            }
+
+            F f;
+            scheduler* pool;
+            std::optional<stored> result;
+    };
+
+    template<typename F>
+    task<F> fork(F f){
+        return task<F>{std::move(f)};
+    }
+
+    // Runs a and b, in parallel if a thread is free to take b
+    template<typename A, typename B>
+    void join(A&& a, B&& b){
+        auto t = fork([&]{ std::invoke(b); });
+        std::invoke(a);
+        t.join();
+    }
+
+    // Problem size below which join() doesn't fork
+    inline constexpr std::size_t default_grain = 1 << 12;
+
+    // join() for a problem of `work` elements: serial below `grain`,
+    // where a fork would cost more than it could save
+    template<typename A, typename B>
+    void join(std::size_t work, A&& a, B&& b, std::size_t grain = default_grain){
+        if (work < grain){
+            std::invoke(a);
+            std::invoke(b);
+        }
+        else join(a, b);
+    }
+
+    inline scheduler::scheduler(unsigned threads){
+        for (unsigned i=0;i<std::max(threads, 1u);++i) deques.push_back(std::make_unique<detail::deque>());
+        for (unsigned i=1;i<deques.size();++i){
+            workers.emplace_back([this, i]{ work(i); });
+        }
+    }
+
+    inline scheduler::~scheduler(){
+        {
+            std::lock_guard lock{m};
+            stopping = true;
+        }
+        start_cv.notify_all();
+
+        for (auto& t : workers) t.join();
+    }
+
+    template<typename F>
+    std::invoke_result_t<F&> scheduler::run(F f){
+        if (detail::this_worker.pool == this) return f();
+
+        std::lock_guard run_lock{run_mutex};
+        {
+            std::lock_guard lock{m};
+            busy.store(true, std::memory_order_relaxed);
+        }
+        start_cv.notify_all();
+
+        // Every task f forked is joined by the time it returns or throws,
+        // so the workers can go back to sleep
+        struct finish{
+            scheduler& s;
+            detail::worker saved = std::exchange(detail::this_worker, {&s, 0});
+
+            ~finish(){
+                s.busy.store(false, std::memory_order_relaxed);
+                detail::this_worker = saved;
+            }
+        } guard{*this};
+
+        return f();
+    }
+
+    // Runs our own newest tasks, then other threads' oldest, until t is
+    // done. If t wasn't stolen it is the first one popped.
+    inline void scheduler::wait(detail::task_base& t){
+        std::size_t self = detail::this_worker.index;
+        while (!t.done.load(std::memory_order_acquire)){
+            detail::task_base* next = deques[self]->pop();
+            if (!next) next = steal(self);
+
+            if (next) next->execute();
+            else std::this_thread::yield();
+        }
+    }
+
+    inline detail::task_base* scheduler::steal(std::size_t thief){
+        // Victims in a different order on each attempt, so that thieves
+        // don't all line up behind the same deque
+        thread_local std::uint64_t seed = 0x9e3779b97f4a7c15ull * (thief + 1);
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+
+        std::size_t n = deques.size();
+        for (std::size_t i=0, start=seed%n;i<n;++i){
+            std::size_t victim = (start + i) % n;
+            if (victim == thief) continue;
+            if (detail::task_base* t = deques[victim]->steal()) return t;
+        }
+        return nullptr;
+    }
+
+    inline void scheduler::work(std::size_t index){
+        detail::this_worker = {this, index};
+        for (;;){
+            {
+                std::unique_lock lock{m};
+                start_cv.wait(lock, [this]{ return stopping || busy.load(std::memory_order_relaxed); });
+                if (stopping) return;
+            }
+
+            while (busy.load(std::memory_order_relaxed)){
+                if (detail::task_base* t = steal(index)) t->execute();
+                else std::this_thread::yield();
+            }
+        }
+    }
+
+} // namespace fork_join
@@ -1,18 +1,7 @@
 #include <iostream>
 #include <set>
 
-struct data{
-    int x;
-    int y;
-};
-
-class Functor{  
-    public:
-        bool operator()(const data& first, const data& second) const {
-            if (first.x != second.x) return first.x < second.x;
-            return first.y > second.y;
-        }
-};
+#include "functors.h"
 
 int main(){
 
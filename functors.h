@@ -0,0 +1,15 @@
+#pragma once
+
+struct data{
+    int x;
+    int y;
+};
+
+// Orders by x ascending, then y descending
+class Functor{  
+    public:
+        bool operator()(const data& first, const data& second) const {
+            if (first.x != second.x) return first.x < second.x;
+            return first.y > second.y;
+        }
+};
@@ -0,0 +1,134 @@
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "bench.h"
+#include "inplace_function.h"
+
+void on_event(int e){
+    std::cout << "free function got " << e << '\n';
+}
+
+int sq(int i){
+    return i * i;
+}
+
+// Calls back before returning, so it can take a function_ref
+int sum_over(int n, function_ref<int(int)> f){
+    int s = 0;
+    for (int i=0;i<n;++i) s += f(i);
+    return s;
+}
+
+// The same for a callback passed down as const std::function&, which has
+// to be built (and here allocated) at every call site
+[[gnu::noinline]] long long apply_std(const std::function<long long(int)>& f){
+    long long s = 0;
+    for (int i=0;i<16;++i) s += f(i);
+    return s;
+}
+
+[[gnu::noinline]] long long apply_ref(function_ref<long long(int)> f){
+    long long s = 0;
+    for (int i=0;i<16;++i) s += f(i);
+    return s;
+}
+
+// Callbacks of different types, as an event loop registers them, so the
+// call in the loop below isn't always to the same target. Each captures
+// 32 bytes, past std::function's 16-byte small buffer in libstdc++.
+template<typename Callback>
+void register_callbacks(std::vector<Callback>& callbacks, std::size_t n, long long& total){
+    callbacks.clear();
+    for (std::size_t i=0;i<n;++i){
+        long long* out = &total;
+        long long a = i, b = i * 3, c = i % 7;
+        switch (i % 4){
+            case 0: callbacks.emplace_back([out, a, b, c](int e){ *out += a + e; (void)b; (void)c; }); break;
+            case 1: callbacks.emplace_back([out, a, b, c](int e){ *out += b - e; (void)a; (void)c; }); break;
+            case 2: callbacks.emplace_back([out, a, b, c](int e){ *out += c * e; (void)a; (void)b; }); break;
+            default: callbacks.emplace_back([out, a, b, c](int e){ *out ^= a + b + c + e; }); break;
+        }
+    }
+}
+
+template<typename Callback>
+void bench_dispatch(const char* name, std::size_t n, int events){
+    std::vector<Callback> callbacks;
+    callbacks.reserve(n);
+    long long total = 0;
+    std::string prefix = name;
+
+    report(prefix + " register x100", time_ms([&]{
+        for (int r=0;r<100;++r) register_callbacks(callbacks, n, total);
+    }));
+    report(prefix + " dispatch", time_ms([&]{
+        for (int e=0;e<events;++e){
+            for (const auto& f : callbacks) f(e);
+        }
+        do_not_optimize(total);
+    }));
+}
+
+int main(){
+    int x = 5;
+    auto f2 = [&x](){ return x + 1; };
+    inplace_function<int()> g2 = f2;
+    x = 25;
+    std::cout << g2() << '\n';
+
+    // Move-only captures are fine, and so is mutable state
+    inplace_function<int()> counter = [p = std::make_unique<int>(0)]() mutable { return ++*p; };
+    counter();
+    auto moved = std::move(counter);
+    std::cout << moved() << ' ' << static_cast<bool>(counter) << '\n';
+
+    inplace_function<void(int), 16> free = on_event;
+    free(3);
+
+    // Too big for 16 bytes: rejected at compile time, where std::function
+    // would quietly allocate
+    // long long a = 1, b = 2, c = 3;
+    // inplace_function<long long(), 16> big = [a, b, c]{ return a + b + c; };     // error: callable too big
+
+    auto square = [](int i){ return i * i; };
+    std::cout << sum_over(4, square) << '\n';
+
+    // A function pointer is stored by value, so one made from a
+    // temporary (&sq) stays valid
+    function_ref<int(int)> by_pointer = &sq;
+    std::cout << by_pointer(7) << ' ' << sum_over(4, sq) << '\n';
+
+    try {
+        inplace_function<void()> empty;
+        empty();
+    }
+    catch (const std::bad_function_call&){
+        std::cout << "empty call throws\n";
+    }
+
+    // Benchmark: register 1024 callbacks, then call every one of them for
+    // each of 10K events
+    constexpr std::size_t n = 1024;
+    constexpr int events = 10'000;
+    std::cout << "\n" << n << " callbacks, " << events << " events\n";
+    bench_dispatch<std::function<void(int)>>("std::function", n, events);
+    bench_dispatch<inplace_function<void(int), 32>>("inplace_function", n, events);
+
+    // Passing a capturing lambda down, 1M times
+    constexpr int calls = 1'000'000;
+    long long a = 1, b = 2, c = 3;
+    report("pass as std::function", time_ms([&]{
+        long long s = 0;
+        for (int i=0;i<calls;++i) s += apply_std([a, b, c, i](int e){ return a * e + b + c + i; });
+        do_not_optimize(s);
+    }));
+    report("pass as function_ref", time_ms([&]{
+        long long s = 0;
+        for (int i=0;i<calls;++i) s += apply_ref([a, b, c, i](int e){ return a * e + b + c + i; });
+        do_not_optimize(s);
+    }));
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace detail
+{
+
+    // How the type-erased call takes each argument: small trivially
+    // copyable ones by value, in registers, rather than by reference
+    template<typename T>
+    using call_param = std::conditional_t<std::is_trivially_copyable_v<T> && sizeof(T) <= 2 * sizeof(void*), T, T&&>;
+
+} // namespace detail
+
+// A move-only std::function that never allocates: the callable lives in a
+// buffer of Capacity bytes inside the wrapper, and one that doesn't fit
+// is a compile error, not a heap allocation. Calls go through a single
+// function pointer kept in the object, with no check for emptiness on
+// the way (an empty one throws std::bad_function_call from that pointer).
+//
+// Move-only callables (a lambda owning a unique_ptr) are fine; in return
+// the wrapper itself can be moved but not copied.
+template<typename Signature, std::size_t Capacity = 32, std::size_t Alignment = alignof(std::max_align_t)>
+class inplace_function;
+
+template<typename R, typename... Args, std::size_t Capacity, std::size_t Alignment>
+class inplace_function<R(Args...), Capacity, Alignment>{
+    public:
+        inplace_function() noexcept = default;
+
+        inplace_function(std::nullptr_t) noexcept {}
+
+        template<typename F>
+            requires (!std::is_same_v<std::remove_cvref_t<F>, inplace_function> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+        inplace_function(F&& f){
+            using T = std::decay_t<F>;
+            static_assert(sizeof(T) <= Capacity, "callable too big for the inline buffer: raise Capacity");
+            static_assert(Alignment % alignof(T) == 0, "callable alignment not supported: raise Alignment");
+            static_assert(std::is_nothrow_move_constructible_v<T>, "callable must be nothrow movable");
+
+            ::new (static_cast<void*>(buffer)) T(std::forward<F>(f));
+            call = &invoke<T>;
+            ops = &ops_for<T>;
+        }
+
+        inplace_function(inplace_function&& other) noexcept {
+            take(other);
+        }
+
+        inplace_function& operator=(inplace_function&& other) noexcept {
+            if (this != &other){
+                reset();
+                take(other);
+            }
+            return *this;
+        }
+
+        inplace_function& operator=(std::nullptr_t) noexcept {
+            reset();
+            return *this;
+        }
+
+        ~inplace_function(){
+            reset();
+        }
+
+        // const like std::function's: the callable itself may be mutable
+        R operator()(Args... args) const {
+            return call(buffer, std::forward<Args>(args)...);
+        }
+
+        explicit operator bool() const noexcept {
+            return ops != nullptr;
+        }
+
+    private:
+        struct operations{
+            void (*relocate)(void* dst, void* src) noexcept;    // move, then destroy the source
+            void (*destroy)(void* p) noexcept;
+        };
+
+        template<typename T>
+        static R invoke(void* p, detail::call_param<Args>... args){
+            if constexpr (std::is_void_v<R>) std::invoke(*static_cast<T*>(p), std::forward<Args>(args)...);
+            else return std::invoke(*static_cast<T*>(p), std::forward<Args>(args)...);
+        }
+
+        static R invoke_empty(void*, detail::call_param<Args>...){
+            throw std::bad_function_call{};
+        }
+
+        template<typename T>
+        static constexpr operations ops_for = {
+            [](void* dst, void* src) noexcept {
+                ::new (dst) T(std::move(*static_cast<T*>(src)));
+                static_cast<T*>(src)->~T();
+            },
+            [](void* p) noexcept {
+                static_cast<T*>(p)->~T();
+            }
+        };
+
+        void take(inplace_function& other) noexcept {
+            if (!other.ops) return;
+            other.ops->relocate(buffer, other.buffer);
+            call = std::exchange(other.call, &invoke_empty);
+            ops = std::exchange(other.ops, nullptr);
+        }
+
+        void reset() noexcept {
+            if (!ops) return;
+            ops->destroy(buffer);
+            call = &invoke_empty;
+            ops = nullptr;
+        }
+
+        alignas(Alignment) mutable std::byte buffer[Capacity];
+        R (*call)(void*, detail::call_param<Args>...) = &invoke_empty;
+        const operations* ops = nullptr;
+};
+
+// A non-owning reference to a callable: two pointers, trivially copyable,
+// for passing callbacks down to functions that call them before
+// returning. It must not outlive what it refers to, so don't store one
+// made from a temporary lambda.
+template<typename Signature>
+class function_ref;
+
+template<typename R, typename... Args>
+class function_ref<R(Args...)>{
+    public:
+        template<typename F>
+            requires (!std::is_same_v<std::remove_cvref_t<F>, function_ref> && std::is_invocable_r_v<R, F&, Args...>)
+        function_ref(F&& f) noexcept {
+            using T = std::remove_reference_t<F>;
+            using P = std::remove_cv_t<T>;
+            if constexpr (std::is_function_v<T>){
+                target.function = reinterpret_cast<void (*)()>(&f);
+                call = &invoke_function<T>;
+            }
+            else if constexpr (std::is_pointer_v<P> && std::is_function_v<std::remove_pointer_t<P>>){
+                // Keep the pointer itself: `f` may be a temporary (`&sq`)
+                target.function = reinterpret_cast<void (*)()>(f);
+                call = &invoke_function<std::remove_pointer_t<P>>;
+            }
+            else {
+                target.object = const_cast<void*>(static_cast<const void*>(std::addressof(f)));
+                call = &invoke_object<T>;
+            }
+        }
+
+        R operator()(Args... args) const {
+            return call(target, std::forward<Args>(args)...);
+        }
+
+    private:
+        // A function pointer can't portably go through void*
+        union target_ptr{
+            void* object;
+            void (*function)();
+        };
+
+        template<typename T>
+        static R invoke_object(target_ptr t, detail::call_param<Args>... args){
+            if constexpr (std::is_void_v<R>) std::invoke(*static_cast<T*>(t.object), std::forward<Args>(args)...);
+            else return std::invoke(*static_cast<T*>(t.object), std::forward<Args>(args)...);
+        }
+
+        template<typename T>
+        static R invoke_function(target_ptr t, detail::call_param<Args>... args){
+            if constexpr (std::is_void_v<R>) std::invoke(reinterpret_cast<T*>(t.function), std::forward<Args>(args)...);
+            else return std::invoke(reinterpret_cast<T*>(t.function), std::forward<Args>(args)...);
+        }
+
+        target_ptr target;
+        R (*call)(target_ptr, detail::call_param<Args>...);
+};
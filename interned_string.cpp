@@ -0,0 +1,360 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <iostream>
+
+#include "bench.h"
+
+class string_pool;
+
+// An immutable string owned by a string_pool. Every distinct string has
+// one node in the pool, so copying a handle is an atomic increment and
+// comparing two handles is a pointer compare. The empty string is a null
+// handle and never touches the pool.
+class interned_string{
+    public:
+        interned_string() = default;
+
+        // Interns `s` in string_pool::global()
+        explicit interned_string(std::string_view s);
+
+        interned_string(const interned_string& other) noexcept;
+        interned_string(interned_string&& other) noexcept
+            : n(std::exchange(other.n, nullptr))
+        {}
+
+        interned_string& operator=(const interned_string& other) noexcept;
+        interned_string& operator=(interned_string&& other) noexcept;
+
+        ~interned_string();
+
+        std::string_view view() const;
+
+        const char* c_str() const {
+            return view().data();
+        }
+
+        std::size_t size() const {
+            return view().size();
+        }
+
+        // Handles sharing this string, for the curious
+        std::size_t use_count() const;
+
+        friend bool operator==(const interned_string& a, const interned_string& b){
+            return a.n == b.n;
+        }
+
+        friend struct std::hash<interned_string>;
+
+    private:
+        friend class string_pool;
+
+        struct node;
+
+        explicit interned_string(node* n)
+            : n(n)
+        {}
+
+        void release() noexcept;
+
+        node* n = nullptr;
+};
+
+// Hands out interned_strings. Strings are spread over shards by hash,
+// each with its own mutex and set, so threads interning different strings
+// rarely wait on each other.
+//
+// A node's count only drops from 1 to 0 under its shard's lock, and
+// intern() only finds nodes under that lock, so a string being released
+// can't be handed out again half-freed. The pool must outlive its handles.
+class string_pool{
+    public:
+        explicit string_pool(std::size_t shard_count = 16);
+
+        string_pool(const string_pool&) = delete;
+        string_pool& operator=(const string_pool&) = delete;
+
+        ~string_pool();
+
+        interned_string intern(std::string_view s);
+
+        // Distinct strings currently alive
+        std::size_t size() const;
+
+        // Never destroyed: handles in other statics may outlive main
+        static string_pool& global(){
+            static string_pool* pool = new string_pool;
+            return *pool;
+        }
+
+    private:
+        friend class interned_string;
+
+        using node = interned_string::node;
+
+        struct node_hash{
+            using is_transparent = void;
+
+            std::size_t operator()(std::string_view s) const {
+                return std::hash<std::string_view>{}(s);
+            }
+
+            std::size_t operator()(const node* n) const;
+        };
+
+        struct node_equal{
+            using is_transparent = void;
+
+            bool operator()(const node* a, const node* b) const {
+                return a == b;
+            }
+
+            bool operator()(std::string_view s, const node* n) const;
+            bool operator()(const node* n, std::string_view s) const;
+        };
+
+        struct alignas(64) shard{
+            mutable std::mutex m;
+            std::unordered_set<node*, node_hash, node_equal> strings;
+        };
+
+        void release(node* n);
+
+        std::unique_ptr<shard[]> shards;
+        std::size_t shard_count;
+};
+
+struct interned_string::node{
+    std::atomic<std::size_t> refs;
+    std::size_t hash;
+    std::size_t length;
+    string_pool* pool;
+
+    // The chars follow the node in the same allocation
+    char* chars(){
+        return reinterpret_cast<char*>(this + 1);
+    }
+
+    std::string_view view() const {
+        return {reinterpret_cast<const char*>(this + 1), length};
+    }
+
+    static node* make(std::string_view s, std::size_t hash, string_pool* pool){
+        void* mem = ::operator new(sizeof(node) + s.size() + 1);
+        node* n = new(mem) node{{1}, hash, s.size(), pool};
+        std::memcpy(n->chars(), s.data(), s.size());
+        n->chars()[s.size()] = '\0';
+        return n;
+    }
+
+    static void destroy(node* n){
+        n->~node();
+        ::operator delete(n);
+    }
+};
+
+template<>
+struct std::hash<interned_string>{
+    std::size_t operator()(const interned_string& s) const {
+        return s.n ? s.n->hash : 0;
+    }
+};
+
+inline std::size_t string_pool::node_hash::operator()(const node* n) const {
+    return n->hash;
+}
+
+inline bool string_pool::node_equal::operator()(std::string_view s, const node* n) const {
+    return s == n->view();
+}
+
+inline bool string_pool::node_equal::operator()(const node* n, std::string_view s) const {
+    return s == n->view();
+}
+
+string_pool::string_pool(std::size_t shard_count)
+    : shards(std::make_unique<shard[]>(shard_count)), shard_count(shard_count)
+{}
+
+string_pool::~string_pool(){
+    for (std::size_t i=0;i<shard_count;++i){
+        for (node* n : shards[i].strings) node::destroy(n);
+    }
+}
+
+interned_string string_pool::intern(std::string_view s){
+    if (s.empty()) return {};
+
+    std::size_t h = node_hash{}(s);
+    shard& sh = shards[h % shard_count];
+
+    std::lock_guard lock{sh.m};
+    auto it = sh.strings.find(s);
+    if (it != sh.strings.end()){
+        (*it)->refs.fetch_add(1, std::memory_order_relaxed);
+        return interned_string{*it};
+    }
+
+    node* n = node::make(s, h, this);
+    try {
+        sh.strings.insert(n);
+    }
+    catch (...){
+        node::destroy(n);
+        throw;
+    }
+    return interned_string{n};
+}
+
+void string_pool::release(node* n){
+    shard& sh = shards[n->hash % shard_count];
+
+    std::lock_guard lock{sh.m};
+    if (n->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;     // copied meanwhile
+
+    sh.strings.erase(n);
+    node::destroy(n);
+}
+
+std::size_t string_pool::size() const {
+    std::size_t total = 0;
+    for (std::size_t i=0;i<shard_count;++i){
+        std::lock_guard lock{shards[i].m};
+        total += shards[i].strings.size();
+    }
+    return total;
+}
+
+interned_string::interned_string(std::string_view s)
+    : interned_string(string_pool::global().intern(s))
+{}
+
+interned_string::interned_string(const interned_string& other) noexcept
+    : n(other.n)
+{
+    if (n) n->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+interned_string& interned_string::operator=(const interned_string& other) noexcept {
+    if (n != other.n){
+        if (other.n) other.n->refs.fetch_add(1, std::memory_order_relaxed);
+        release();
+        n = other.n;
+    }
+    return *this;
+}
+
+interned_string& interned_string::operator=(interned_string&& other) noexcept {
+    if (this != &other){
+        release();
+        n = std::exchange(other.n, nullptr);
+    }
+    return *this;
+}
+
+interned_string::~interned_string(){
+    release();
+}
+
+// Drops a reference without the lock unless it may be the last one
+void interned_string::release() noexcept {
+    if (!n) return;
+
+    std::size_t r = n->refs.load(std::memory_order_relaxed);
+    while (r > 1){
+        if (n->refs.compare_exchange_weak(r, r - 1, std::memory_order_release, std::memory_order_relaxed)) return;
+    }
+    n->pool->release(n);
+}
+
+std::string_view interned_string::view() const {
+    return n ? n->view() : std::string_view{""};
+}
+
+std::size_t interned_string::use_count() const {
+    return n ? n->refs.load(std::memory_order_relaxed) : 0;
+}
+
+int main(){
+    interned_string a{"hello"};
+    interned_string b{std::string{"hel"} + "lo"};
+    interned_string c = a;
+    interned_string empty;
+    std::cout << (a == b) << ' ' << a.use_count() << ' ' << c.view() << ' '
+              << (empty == interned_string{""}) << ' ' << string_pool::global().size() << '\n';
+    a = interned_string{};
+    b = interned_string{};
+    c = interned_string{};
+    std::cout << string_pool::global().size() << '\n';
+
+    // Benchmark: 4096 distinct strings copied 4M times, then compared
+    constexpr std::size_t distinct = 4096;
+    constexpr std::size_t n = 1 << 22;
+    std::vector<std::string> words;
+    for (std::size_t i=0;i<distinct;++i) words.push_back("instrument/" + std::to_string(i * 7919) + "/venue-" + std::to_string(i % 13));
+
+    std::vector<interned_string> interned;
+    for (const auto& w : words) interned.emplace_back(w);
+
+    std::vector<std::string> copies;
+    std::vector<interned_string> handles;
+    copies.reserve(n);
+    handles.reserve(n);
+
+    std::cout << "\n" << n << " copies of " << distinct << " strings\n";
+    report("copy std::string", time_ms([&]{
+        copies.clear();
+        for (std::size_t i=0;i<n;++i) copies.push_back(words[(i * 31) % distinct]);
+    }));
+    report("copy interned_string", time_ms([&]{
+        handles.clear();
+        for (std::size_t i=0;i<n;++i) handles.push_back(interned[(i * 31) % distinct]);
+    }));
+
+    std::size_t heap = 0;
+    for (const auto& s : copies) heap += s.capacity() > 15 ? s.capacity() + 1 : 0;
+    std::cout << "  std::string memory      " << ((n * sizeof(std::string) + heap) >> 20) << " MB\n";
+    std::cout << "  interned_string memory  " << ((n * sizeof(interned_string)) >> 20) << " MB + "
+              << string_pool::global().size() << " nodes\n";
+
+    report("compare std::string", time_ms([&]{
+        std::size_t same = 0;
+        for (std::size_t i=1;i<n;++i) same += copies[i] == copies[i - distinct / 2 * (i >= distinct / 2)];
+        do_not_optimize(same);
+    }));
+    report("compare interned_string", time_ms([&]{
+        std::size_t same = 0;
+        for (std::size_t i=1;i<n;++i) same += handles[i] == handles[i - distinct / 2 * (i >= distinct / 2)];
+        do_not_optimize(same);
+    }));
+
+    // Interning from several threads, one lock against sharded locks
+    unsigned threads = std::max(4u, std::thread::hardware_concurrency());
+    for (std::size_t shard_count : {std::size_t{1}, std::size_t{64}}){
+        string_pool pool{shard_count};
+        std::string name = "intern, " + std::to_string(threads) + " threads, " + std::to_string(shard_count) + " shard(s)";
+        report(name, time_ms([&]{
+            std::vector<std::thread> pool_threads;
+            for (unsigned t=0;t<threads;++t){
+                pool_threads.emplace_back([&, t]{
+                    std::vector<interned_string> mine;
+                    mine.reserve(n / threads);
+                    for (std::size_t i=t;i<n;i+=threads) mine.push_back(pool.intern(words[i % distinct]));
+                });
+            }
+            for (auto& th : pool_threads) th.join();
+        }, 3));
+    }
+}
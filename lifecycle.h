@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+// Counts constructions, copies, moves, assignments and destructions per
+// type, for checking that a hot path really gets elision and moves:
+//
+//     class A : public lifecycle::counted<A> { ... };
+//
+//     auto before = lifecycle::snapshot<A>();
+//     run();
+//     assert((lifecycle::snapshot<A>() - before).copied == 0);
+//
+// Each thread bumps its own counters (a plain relaxed store, no locked
+// instruction) and snapshot() adds them up when asked. Counting is on when
+// LIFECYCLE_COUNTERS is defined; otherwise counted<T> is an empty base
+// with no special members of its own, so T keeps its size and stays
+// trivially copyable, and snapshot() is all zeros.
+//
+// A type with user-written copy or move constructors must pass the source
+// on to the base (`A(const A& a) : counted(a)`), or they count as plain
+// constructions.
+namespace lifecycle
+{
+
+    // Only the default for counted<T>'s second argument. Internal
+    // linkage, not inline, since its value may differ between translation
+    // units; a counted type's base does too, so define the macro the same
+    // way wherever a given type is seen.
+#ifdef LIFECYCLE_COUNTERS
+    constexpr bool enabled = true;
+#else
+    constexpr bool enabled = false;
+#endif
+
+    struct counts{
+        std::uint64_t constructed = 0;
+        std::uint64_t copied = 0;
+        std::uint64_t moved = 0;
+        std::uint64_t copy_assigned = 0;
+        std::uint64_t move_assigned = 0;
+        std::uint64_t destroyed = 0;
+
+        // Objects created and not yet destroyed
+        std::int64_t alive() const {
+            return static_cast<std::int64_t>(constructed + copied + moved - destroyed);
+        }
+
+        friend counts operator-(const counts& a, const counts& b){
+            return {a.constructed - b.constructed, a.copied - b.copied, a.moved - b.moved,
+                    a.copy_assigned - b.copy_assigned, a.move_assigned - b.move_assigned,
+                    a.destroyed - b.destroyed};
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, const counts& c){
+            return os << "constructed " << c.constructed << ", copied " << c.copied
+                      << ", moved " << c.moved << ", copy-assigned " << c.copy_assigned
+                      << ", move-assigned " << c.move_assigned << ", destroyed " << c.destroyed;
+        }
+    };
+
+    namespace detail
+    {
+
+        enum event { constructed, copied, moved, copy_assigned, move_assigned, destroyed, events };
+
+        // One thread's counters for one type. Only the owning thread
+        // writes them, so an increment doesn't need to be atomic, only
+        // the load and store so other threads can read them.
+        struct block{
+            std::atomic<std::uint64_t> n[events] = {};
+
+            void bump(event e){
+                n[e].store(n[e].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+
+            void add_to(counts& c) const {
+                c.constructed += n[constructed].load(std::memory_order_relaxed);
+                c.copied += n[copied].load(std::memory_order_relaxed);
+                c.moved += n[moved].load(std::memory_order_relaxed);
+                c.copy_assigned += n[copy_assigned].load(std::memory_order_relaxed);
+                c.move_assigned += n[move_assigned].load(std::memory_order_relaxed);
+                c.destroyed += n[destroyed].load(std::memory_order_relaxed);
+            }
+        };
+
+        // The blocks of the live threads, plus what exited threads counted
+        template<typename T>
+        struct registry{
+            static inline std::mutex m;
+            static inline std::vector<block*> live;
+            static inline counts retired;
+        };
+
+        template<typename T>
+        struct thread_block{
+            block b;
+
+            thread_block(){
+                std::lock_guard lock{registry<T>::m};
+                registry<T>::live.push_back(&b);
+            }
+
+            ~thread_block(){
+                std::lock_guard lock{registry<T>::m};
+                b.add_to(registry<T>::retired);
+                std::erase(registry<T>::live, &b);
+            }
+        };
+
+        template<typename T>
+        block& this_thread(){
+            thread_local thread_block<T> tb;
+            return tb.b;
+        }
+
+    } // namespace detail
+
+    template<typename T, bool Enabled = enabled>
+    class counted{};
+
+    template<typename T>
+    class counted<T, true>{
+        public:
+            counted() noexcept {
+                bump(detail::constructed);
+            }
+
+            counted(const counted&) noexcept {
+                bump(detail::copied);
+            }
+
+            counted(counted&&) noexcept {
+                bump(detail::moved);
+            }
+
+            counted& operator=(const counted&) noexcept {
+                bump(detail::copy_assigned);
+                return *this;
+            }
+
+            counted& operator=(counted&&) noexcept {
+                bump(detail::move_assigned);
+                return *this;
+            }
+
+            ~counted(){
+                bump(detail::destroyed);
+            }
+
+        private:
+            static void bump(detail::event e){
+                detail::this_thread<T>().bump(e);
+            }
+    };
+
+    // All threads' counts for T so far; zeros unless T derives from an
+    // enabled counted<T>
+    template<typename T>
+    counts snapshot(){
+        if constexpr (!std::is_base_of_v<counted<T, true>, T>) return {};
+
+        std::lock_guard lock{detail::registry<T>::m};
+        counts c = detail::registry<T>::retired;
+        for (const detail::block* b : detail::registry<T>::live) b->add_to(c);
+        return c;
+    }
+
+} // namespace lifecycle
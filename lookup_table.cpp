@@ -0,0 +1,141 @@
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include <iostream>
+
+#include "bench.h"
+#include "lookup_table.h"
+
+// CRC-32 (the zlib/Ethernet one): the table holds the CRC of each byte
+// value, so the checksum takes one lookup per byte instead of 8 shifts
+constexpr auto crc32_entry = [](std::size_t byte){
+    std::uint32_t c = static_cast<std::uint32_t>(byte);
+    for (int k=0;k<8;++k) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+    return c;
+};
+
+constinit const auto crc32_table = make_table<256>(crc32_entry);
+
+std::uint32_t crc32(const std::uint8_t* p, std::size_t n){
+    std::uint32_t c = 0xffffffffu;
+    for (std::size_t i=0;i<n;++i) c = crc32_table[(c ^ p[i]) & 0xff] ^ (c >> 8);
+    return c ^ 0xffffffffu;
+}
+
+std::uint32_t crc32_bitwise(const std::uint8_t* p, std::size_t n){
+    std::uint32_t c = 0xffffffffu;
+    for (std::size_t i=0;i<n;++i){
+        c ^= p[i];
+        for (int k=0;k<8;++k) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+    }
+    return c ^ 0xffffffffu;
+}
+
+// sRGB byte to linear light in 16 bits. std::pow isn't constexpr, so
+// x^2.4 is x^2 times the fifth root of x^2, by Newton's method.
+constexpr double fifth_root(double v){
+    if (v == 0) return 0;
+    double x = 1;
+    for (int k=0;k<100;++k) x -= (x * x * x * x * x - v) / (5 * x * x * x * x);
+    return x;
+}
+
+constexpr auto srgb_to_linear = [](std::size_t byte){
+    double c = byte / 255.0;
+    double x = (c + 0.055) / 1.055;
+    double linear = c <= 0.04045 ? c / 12.92 : x * x * fifth_root(x * x);
+    return static_cast<std::uint16_t>(linear * 65535 + 0.5);
+};
+
+constinit const auto gamma_table = make_table<256>(srgb_to_linear);
+
+// Two dimensions: multiplication in GF(2^8), the field of AES and of
+// Reed-Solomon codes, for all 256 x 256 pairs (64 KB, right at the budget)
+constexpr auto gf256_multiply = [](std::size_t a, std::size_t b){
+    std::uint8_t product = 0;
+    for (int k=0;k<8;++k){
+        if (b & 1) product ^= a;
+        a = (a << 1) ^ (a & 0x80 ? 0x11b : 0);
+        b >>= 1;
+    }
+    return product;
+};
+
+constinit const auto gf256_table = make_table<256, 256>(gf256_multiply);
+
+// Bit reversal of a byte, for FFT reordering and the like
+constinit const auto reversed_bits = make_table<256>([](std::size_t byte){
+    std::uint8_t r = 0;
+    for (int k=0;k<8;++k) r |= ((byte >> k) & 1) << (7 - k);
+    return r;
+});
+
+// 16-bit bit reversal is 128 KB, so it asks for the room explicitly
+constinit const auto reversed_bits16 = make_table_within<128 * 1024, 65536>([](std::size_t v){
+    std::uint16_t r = 0;
+    for (int k=0;k<16;++k) r |= ((v >> k) & 1) << (15 - k);
+    return r;
+});
+
+// Over budget: a compile error
+// constinit const auto too_big = make_table<256, 256>([](std::size_t a, std::size_t b){ return a * b; });   // error: table over budget
+
+int main(){
+    const std::uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    std::cout << std::hex << crc32(check, 9) << std::dec << ' '            // cbf43926, the standard check value
+              << gamma_table[128] << ' ' << int(gf256_table[0x57][0x83]) << ' '   // 0xc1 in FIPS-197
+              << int(reversed_bits[1]) << ' ' << reversed_bits16[1] << '\n';
+    static_assert(gf256_multiply(0x57, 0x13) == 0xfe);
+
+    // Benchmark: each table against computing the values per call, and
+    // against building the table at startup
+    std::vector<std::uint8_t> bytes(16 << 20);
+    std::mt19937 gen{42};
+    for (auto& b : bytes) b = static_cast<std::uint8_t>(gen());
+    std::cout << "\n" << (bytes.size() >> 20) << " MB\n";
+
+    report("crc32 bitwise", time_ms([&]{ do_not_optimize(crc32_bitwise(bytes.data(), bytes.size())); }, 3));
+    report("crc32 table", time_ms([&]{ do_not_optimize(crc32(bytes.data(), bytes.size())); }, 3));
+    if (crc32(bytes.data(), bytes.size()) != crc32_bitwise(bytes.data(), bytes.size())) throw std::logic_error{"crc32 table is wrong"};
+
+    std::vector<std::uint16_t> linear(bytes.size());
+    report("gamma std::pow", time_ms([&]{
+        for (std::size_t i=0;i<bytes.size();++i){
+            double c = bytes[i] / 255.0;
+            double l = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+            linear[i] = static_cast<std::uint16_t>(l * 65535 + 0.5);
+        }
+        do_not_optimize(linear.data());
+    }, 3));
+    report("gamma table", time_ms([&]{
+        for (std::size_t i=0;i<bytes.size();++i) linear[i] = gamma_table[bytes[i]];
+        do_not_optimize(linear.data());
+    }, 3));
+    for (int v=0;v<256;++v){
+        double c = v / 255.0;
+        double l = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+        if (gamma_table[v] != static_cast<std::uint16_t>(l * 65535 + 0.5)) throw std::logic_error{"gamma table is wrong"};
+    }
+
+    // What the compile-time tables save at startup
+    report("build crc32 + gamma at startup", time_ms([&]{
+        std::array<std::uint32_t, 256> crc;
+        std::array<std::uint16_t, 256> gamma;
+        for (std::size_t i=0;i<256;++i){
+            crc[i] = crc32_entry(i);
+            gamma[i] = srgb_to_linear(i);
+        }
+        do_not_optimize(crc);
+        do_not_optimize(gamma);
+    }));
+    report("build gf256 at startup", time_ms([&]{
+        static table<std::uint8_t, 256, 256> gf;
+        for (std::size_t a=0;a<256;++a){
+            for (std::size_t b=0;b<256;++b) gf[a][b] = gf256_multiply(a, b);
+        }
+        do_not_optimize(gf);
+    }));
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+// Lookup tables filled in by the compiler: make_table<N>(f) is
+// std::array{f(0), f(1), ..., f(N-1)}, computed at compile time, so a
+// table of CRCs or gamma values costs nothing at startup and nothing per
+// call. f is a lambda that can run at compile time (any lambda without
+// captures that only does constexpr things):
+//
+//     constinit const auto squares = make_table<16>([](std::size_t i){ return i * i; });
+//
+// More sizes make nested tables, indexed in the same order, with f taking
+// one index per dimension: make_table<4, 8>(f)[i][j] == f(i, j).
+//
+// Tables go into the binary, so there is a budget: a table over 64 KB is
+// a compile error rather than a quietly bigger executable. A table that
+// needs more says so where it is made, with make_table_within<Bytes, N...>.
+// The budget is a template argument rather than a macro, so translation
+// units with different budgets still agree on every definition.
+inline constexpr std::size_t default_table_budget = 64 * 1024;
+
+namespace detail
+{
+
+    template<typename T, std::size_t N, std::size_t... Rest>
+    struct nested_array{
+        using type = std::array<typename nested_array<T, Rest...>::type, N>;
+    };
+
+    template<typename T, std::size_t N>
+    struct nested_array<T, N>{
+        using type = std::array<T, N>;
+    };
+
+    template<std::size_t>
+    using index = std::size_t;
+
+} // namespace detail
+
+template<typename T, std::size_t... Dims>
+using table = typename detail::nested_array<T, Dims...>::type;
+
+template<std::size_t Budget, std::size_t N, std::size_t... Rest, typename F>
+consteval auto make_table_within(F f){
+    using T = std::invoke_result_t<F&, std::size_t, detail::index<Rest>...>;
+    static_assert(sizeof(table<T, N, Rest...>) <= Budget, "table over budget: shrink it or use make_table_within");
+
+    table<T, N, Rest...> result{};
+    for (std::size_t i=0;i<N;++i){
+        if constexpr (sizeof...(Rest) == 0) result[i] = f(i);
+        else result[i] = make_table_within<Budget, Rest...>([&](auto... js){ return f(i, js...); });
+    }
+    return result;
+}
+
+template<std::size_t N, std::size_t... Rest, typename F>
+consteval auto make_table(F f){
+    return make_table_within<default_table_budget, N, Rest...>(f);
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// A large anonymous mapping used as growable storage. The whole
+// reservation is mapped up front with MAP_NORESERVE, so physical pages
+// are only committed when first touched. Growing past the reservation
+// extends the mapping with mremap, which moves page tables rather than
+// copying data.
+//
+// With huge pages requested the reservation is 2 MiB aligned and marked
+// MADV_HUGEPAGE; if transparent huge pages are unavailable madvise just
+// fails and normal pages are used.
+class mapped_region{
+    public:
+        static constexpr std::size_t huge_page_size = std::size_t{2} << 20;
+
+        mapped_region(std::size_t reserve_bytes, bool huge_pages);
+
+        mapped_region(const mapped_region&) = delete;
+        mapped_region& operator=(const mapped_region&) = delete;
+
+        ~mapped_region();
+
+        std::byte* data() const {
+            return base;
+        }
+
+        std::size_t reserved() const {
+            return reserved_bytes;
+        }
+
+        std::size_t committed() const {
+            return committed_bytes;
+        }
+
+        // Whether huge pages were asked for, and whether the kernel took it
+        bool huge_pages_requested() const {
+            return huge;
+        }
+
+        bool huge_pages_enabled() const {
+            return huge_enabled;
+        }
+
+        // Makes the first `bytes` bytes usable. Returns false, changing
+        // nothing, if that needs a bigger mapping that can only be had by
+        // moving it and `may_move` is false.
+        bool commit(std::size_t bytes, bool may_move);
+
+        // Returns the pages past `bytes` to the kernel
+        void decommit(std::size_t bytes);
+
+    private:
+        std::size_t round_up(std::size_t bytes) const {
+            std::size_t unit = huge ? huge_page_size : page_size;
+            return (bytes + unit - 1) / unit * unit;
+        }
+
+        void advise();
+
+        std::byte* base = nullptr;
+        std::size_t reserved_bytes = 0;
+        std::size_t committed_bytes = 0;
+        std::size_t page_size = 4096;
+        bool huge;
+        bool huge_enabled = false;
+};
+
+#ifdef __linux__
+
+inline mapped_region::mapped_region(std::size_t reserve_bytes, bool huge_pages)
+    : huge(huge_pages)
+{
+    page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    reserved_bytes = round_up(std::max<std::size_t>(reserve_bytes, 1));
+
+    // Over-map by one huge page so the start can be aligned to one
+    std::size_t slack = huge ? huge_page_size : 0;
+    void* mem = ::mmap(nullptr, reserved_bytes + slack, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem == MAP_FAILED) throw std::bad_alloc{};
+
+    auto addr = reinterpret_cast<std::uintptr_t>(mem);
+    auto aligned = huge ? (addr + slack - 1) / slack * slack : addr;
+    if (std::size_t head = aligned - addr) ::munmap(mem, head);
+    if (std::size_t tail = slack - (aligned - addr)) ::munmap(reinterpret_cast<void*>(aligned + reserved_bytes), tail);
+
+    base = reinterpret_cast<std::byte*>(aligned);
+    advise();
+}
+
+inline mapped_region::~mapped_region(){
+    if (base) ::munmap(base, reserved_bytes);
+}
+
+inline void mapped_region::advise(){
+#ifdef MADV_HUGEPAGE
+    if (huge) huge_enabled = ::madvise(base, reserved_bytes, MADV_HUGEPAGE) == 0;
+#endif
+}
+
+inline bool mapped_region::commit(std::size_t bytes, bool may_move){
+    if (bytes > reserved_bytes){
+        std::size_t new_reserved = round_up(std::max(bytes, reserved_bytes * 2));
+
+        void* mem = ::mremap(base, reserved_bytes, new_reserved, 0);
+        if (mem == MAP_FAILED){
+            if (!may_move) return false;
+
+            mem = ::mremap(base, reserved_bytes, new_reserved, MREMAP_MAYMOVE);
+            if (mem == MAP_FAILED) throw std::bad_alloc{};
+        }
+
+        base = static_cast<std::byte*>(mem);
+        reserved_bytes = new_reserved;
+        advise();
+    }
+
+    committed_bytes = std::max(committed_bytes, bytes);
+    return true;
+}
+
+inline void mapped_region::decommit(std::size_t bytes){
+    std::size_t keep = (bytes + page_size - 1) / page_size * page_size;
+    if (keep < committed_bytes) ::madvise(base + keep, committed_bytes - keep, MADV_DONTNEED);
+    committed_bytes = bytes;
+}
+
+#else
+
+inline mapped_region::mapped_region(std::size_t, bool huge_pages)
+    : huge(huge_pages)
+{
+    throw std::runtime_error{"mapped_region needs Linux"};
+}
+
+inline mapped_region::~mapped_region(){}
+
+inline bool mapped_region::commit(std::size_t, bool){
+    return false;
+}
+
+inline void mapped_region::decommit(std::size_t){}
+
+#endif
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <thread>
+#include <vector>
+
+namespace parallel
+{
+
+    // Fixed set of worker threads that split an index range between them
+    // (and the calling thread). Indices are handed out one at a time from
+    // an atomic counter, so uneven chunks still balance out.
+    //
+    // run() is not reentrant: a job must not call run() on the same pool.
+    class thread_pool{
+        public:
+            explicit thread_pool(unsigned threads = std::thread::hardware_concurrency());
+
+            thread_pool(const thread_pool&) = delete;
+            thread_pool& operator=(const thread_pool&) = delete;
+
+            ~thread_pool();
+
+            // Threads taking part in run(), the caller included
+            unsigned size() const {
+                return static_cast<unsigned>(workers.size()) + 1;
+            }
+
+            // Calls f(i) for every i in [0, n) and waits for all of them.
+            // The first exception thrown by f is rethrown here.
+            void run(std::size_t n, const std::function<void(std::size_t)>& f);
+
+            static thread_pool& global(){
+                static thread_pool pool;
+                return pool;
+            }
+
+        private:
+            void work();
+            void drain();
+
+            std::vector<std::thread> workers;
+
+            std::mutex run_mutex;               // one run() at a time
+            std::mutex m;
+            std::condition_variable start_cv;
+            std::condition_variable done_cv;
+            std::uint64_t generation = 0;
+            bool stopping = false;
+            std::size_t active = 0;
+
+            const std::function<void(std::size_t)>* job = nullptr;
+            std::size_t job_size = 0;
+            std::atomic<std::size_t> next{0};
+            std::exception_ptr error;
+    };
+
+    inline thread_pool::thread_pool(unsigned threads){
+        for (unsigned i=1;i<std::max(threads, 1u);++i){
+            workers.emplace_back([this]{ work(); });
+        }
+    }
+
+    inline thread_pool::~thread_pool(){
+        {
+            std::lock_guard lock{m};
+            stopping = true;
+        }
+        start_cv.notify_all();
+
+        for (auto& t : workers) t.join();
+    }
+
+    inline void thread_pool::run(std::size_t n, const std::function<void(std::size_t)>& f){
+        std::lock_guard run_lock{run_mutex};
+        {
+            std::lock_guard lock{m};
+            job = &f;
+            job_size = n;
+            next.store(0, std::memory_order_relaxed);
+            error = nullptr;
+            active = workers.size();
+            ++generation;
+        }
+        start_cv.notify_all();
+
+        drain();
+
+        std::unique_lock lock{m};
+        done_cv.wait(lock, [this]{ return active == 0; });
+        job = nullptr;
+
+        if (error) std::rethrow_exception(error);
+    }
+
+    inline void thread_pool::work(){
+        std::uint64_t seen = 0;
+        for (;;){
+            {
+                std::unique_lock lock{m};
+                start_cv.wait(lock, [&]{ return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+
+            drain();
+
+            std::lock_guard lock{m};
+            if (--active == 0) done_cv.notify_one();
+        }
+    }
+
+    inline void thread_pool::drain(){
+        for (;;){
+            std::size_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= job_size) return;
+
+            try {
+                (*job)(i);
+            }
+            catch (...){
+                std::lock_guard lock{m};
+                if (!error) error = std::current_exception();
+            }
+        }
+    }
+
+    // Elements per task; below this the algorithms run serially
+    inline constexpr std::size_t default_grain = 1 << 14;
+
+    // Calls f(begin, end) on consecutive chunks of [0, n) of `grain`
+    // elements each, in parallel
+    template<typename F>
+    void for_chunks(std::size_t n, std::size_t grain, F&& f){
+        std::size_t chunks = (n + grain - 1) / grain;
+        if (chunks <= 1){
+            if (n) f(std::size_t{0}, n);
+            return;
+        }
+
+        thread_pool::global().run(chunks, [&](std::size_t c){
+            f(c * grain, std::min(n, (c + 1) * grain));
+        });
+    }
+
+    template<std::ranges::contiguous_range R, typename F>
+    void for_each(R&& r, F f, std::size_t grain = default_grain){
+        auto first = std::ranges::data(r);
+        for_chunks(std::ranges::size(r), grain, [&](std::size_t b, std::size_t e){
+            for (std::size_t i=b;i<e;++i) f(first[i]);
+        });
+    }
+
+    // out[i] = f(in[i]); `out` must have room for as many elements as `in`
+    template<std::ranges::contiguous_range In, std::ranges::contiguous_range Out, typename F>
+    void transform(In&& in, Out&& out, F f, std::size_t grain = default_grain){
+        auto src = std::ranges::data(in);
+        auto dst = std::ranges::data(out);
+        for_chunks(std::ranges::size(in), grain, [&](std::size_t b, std::size_t e){
+            for (std::size_t i=b;i<e;++i) dst[i] = f(src[i]);
+        });
+    }
+
+    // Like std::reduce: each chunk is folded on its own and the partial
+    // results are combined in order, so `op` only has to be associative
+    template<std::ranges::contiguous_range R, typename T, typename Op = std::plus<>>
+    T reduce(R&& r, T init, Op op = {}, std::size_t grain = default_grain){
+        auto first = std::ranges::data(r);
+        std::size_t n = std::ranges::size(r);
+
+        std::vector<std::optional<T>> partial((n + grain - 1) / grain);
+        for_chunks(n, grain, [&](std::size_t b, std::size_t e){
+            T acc = first[b];
+            for (std::size_t i=b+1;i<e;++i) acc = op(std::move(acc), first[i]);
+            partial[b / grain] = std::move(acc);
+        });
+
+        for (auto& x : partial) init = op(std::move(init), std::move(*x));
+        return init;
+    }
+
+} // namespace parallel
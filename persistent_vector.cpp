@@ -0,0 +1,290 @@
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+// A vector that lives in a file. The file is a small header followed by
+// the elements exactly as they are in memory, and it is mapped with
+// MAP_SHARED, so reopening it is just an mmap: no parsing, no copying,
+// and pages are read in as they are touched.
+//
+// That only works for types that can be copied as raw bytes, hence the
+// trivially copyable restriction (see trivial_types.cpp). Pointers in T
+// would of course be meaningless in the next process.
+template<typename T>
+class persistent_vector{
+    static_assert(std::is_trivially_copyable_v<T>, "persistent_vector stores raw bytes");
+
+    public:
+        static constexpr std::uint32_t version = 1;
+
+        // Opens `path`, creating it if it doesn't exist. Throws
+        // std::system_error on I/O errors and std::runtime_error if the
+        // file holds something other than a persistent_vector<T>.
+        explicit persistent_vector(const std::filesystem::path& path);
+
+        persistent_vector(const persistent_vector&) = delete;
+        persistent_vector& operator=(const persistent_vector&) = delete;
+
+        ~persistent_vector();
+
+        void push_back(const T&);
+        void pop_back();
+
+        void reserve(std::size_t n);
+
+        // Flushes the mapping to disk; otherwise the kernel does it on its own time
+        void sync();
+
+        std::size_t size() const {
+            return hdr->count;
+        }
+
+        std::size_t capacity() const {
+            return hdr->capacity;
+        }
+
+        T* begin(){
+            return p;
+        }
+
+        T* end(){
+            return p + hdr->count;
+        }
+
+        T& operator[](std::size_t i){
+            return p[i];
+        }
+
+        void print() const {
+            for (std::size_t i=0;i<hdr->count;++i){
+                std::cout << *(p + i) << ' ';
+            }
+            std::cout << '\n';
+        }
+
+    private:
+        struct header{
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t element_size;
+            std::uint32_t element_align;
+            std::uint32_t reserved;
+            std::uint64_t count;
+            std::uint64_t capacity;
+        };
+
+        // elements start at a fixed offset, so T can be aligned up to that
+        static constexpr std::size_t data_offset = 64;
+        static_assert(sizeof(header) <= data_offset);
+        static_assert(alignof(T) <= data_offset);
+
+        static constexpr char file_magic[8] = {'P', 'V', 'E', 'C', 'T', 'O', 'R', '\0'};
+
+        static std::size_t file_size(std::size_t cap){
+            return data_offset + cap * sizeof(T);
+        }
+
+        void map(std::size_t bytes);
+        void grow(std::size_t new_cap);
+
+        int fd = -1;
+        std::byte* base = nullptr;
+        std::size_t mapped_bytes = 0;
+        header* hdr = nullptr;
+        T* p = nullptr;
+};
+
+[[noreturn]] inline void throw_errno(const char* what){
+    throw std::system_error{errno, std::generic_category(), what};
+}
+
+template<typename T>
+persistent_vector<T>::persistent_vector(const std::filesystem::path& path){
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) throw_errno("open");
+
+    try {
+        struct stat st;
+        if (::fstat(fd, &st) < 0) throw_errno("fstat");
+
+        if (st.st_size == 0){
+            std::size_t cap = 16;
+            if (::ftruncate(fd, file_size(cap)) < 0) throw_errno("ftruncate");
+            map(file_size(cap));
+
+            std::memcpy(hdr->magic, file_magic, sizeof(file_magic));
+            hdr->version = version;
+            hdr->element_size = sizeof(T);
+            hdr->element_align = alignof(T);
+            hdr->count = 0;
+            hdr->capacity = cap;
+            return;
+        }
+
+        if (static_cast<std::size_t>(st.st_size) < data_offset)
+            throw std::runtime_error{"persistent_vector: file too small"};
+
+        map(st.st_size);
+
+        if (std::memcmp(hdr->magic, file_magic, sizeof(file_magic)) != 0)
+            throw std::runtime_error{"persistent_vector: not a persistent_vector file"};
+        if (hdr->version != version)
+            throw std::runtime_error{"persistent_vector: unsupported version"};
+        if (hdr->element_size != sizeof(T) || hdr->element_align != alignof(T))
+            throw std::runtime_error{"persistent_vector: element type mismatch"};
+        if (hdr->capacity == 0 || hdr->count > hdr->capacity || file_size(hdr->capacity) > mapped_bytes)
+            throw std::runtime_error{"persistent_vector: corrupt header"};
+    }
+    catch (...){
+        if (base) ::munmap(base, mapped_bytes);
+        ::close(fd);
+        throw;
+    }
+}
+
+template<typename T>
+persistent_vector<T>::~persistent_vector(){
+    ::munmap(base, mapped_bytes);
+    ::close(fd);
+}
+
+template<typename T>
+void persistent_vector<T>::map(std::size_t bytes){
+    void* mem = base
+        ? ::mremap(base, mapped_bytes, bytes, MREMAP_MAYMOVE)
+        : ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) throw_errno("mmap");
+
+    base = static_cast<std::byte*>(mem);
+    mapped_bytes = bytes;
+    hdr = reinterpret_cast<header*>(base);
+    p = reinterpret_cast<T*>(base + data_offset);
+}
+
+// The file is extended first and the mapping follows it; mremap moves
+// page tables, so the existing elements are never copied
+template<typename T>
+void persistent_vector<T>::grow(std::size_t new_cap){
+    if (::ftruncate(fd, file_size(new_cap)) < 0) throw_errno("ftruncate");
+    map(file_size(new_cap));
+    hdr->capacity = new_cap;
+}
+
+template<typename T>
+void persistent_vector<T>::push_back(const T& x){
+    if (hdr->count == hdr->capacity){
+        T tmp = x;      // x may live in the mapping that is about to move
+        grow(hdr->capacity * 2);
+        p[hdr->count++] = tmp;
+        return;
+    }
+
+    p[hdr->count++] = x;
+}
+
+template<typename T>
+void persistent_vector<T>::pop_back(){
+    --hdr->count;
+}
+
+template<typename T>
+void persistent_vector<T>::reserve(std::size_t n){
+    if (n > hdr->capacity) grow(n);
+}
+
+template<typename T>
+void persistent_vector<T>::sync(){
+    if (::msync(base, mapped_bytes, MS_SYNC) < 0) throw_errno("msync");
+}
+
+struct record{
+    std::uint64_t id;
+    double price;
+    std::int32_t quantity;
+    char symbol[12];
+};
+
+int main(){
+    auto path = std::filesystem::temp_directory_path() / "persistent_vector_demo.dat";
+    std::filesystem::remove(path);
+
+    {
+        persistent_vector<int> v{path};
+        for (int i=0;i<10;++i) v.push_back(i * i);
+        v.pop_back();
+        v.print();
+    }
+    {
+        persistent_vector<int> v{path};     // same elements, straight from the file
+        std::cout << v.size() << ' ' << v.capacity() << '\n';
+        v.print();
+    }
+
+    try {
+        persistent_vector<double> wrong{path};
+    }
+    catch (const std::exception& e){
+        std::cout << e.what() << '\n';
+    }
+    std::filesystem::remove(path);
+
+    // A header claiming capacity 0 would make push_back "grow" to 0 and
+    // write past the mapping
+    {
+        persistent_vector<int> empty{path};
+    }
+    {
+        std::fstream f{path, std::ios::in | std::ios::out | std::ios::binary};
+        const std::uint64_t zero = 0;
+        f.seekp(32);        // header::capacity
+        f.write(reinterpret_cast<const char*>(&zero), sizeof(zero));
+    }
+    try {
+        persistent_vector<int> broken{path};
+    }
+    catch (const std::exception& e){
+        std::cout << e.what() << '\n';
+    }
+    std::filesystem::remove(path);
+
+    // Benchmark: build 16M records once, then time reopening the file
+    // against rebuilding them the way a process start would
+    constexpr std::size_t n = 1 << 24;
+    auto build = [](persistent_vector<record>& v){
+        v.reserve(n);
+        for (std::size_t i=0;i<n;++i){
+            v.push_back({i, i * 0.5, static_cast<std::int32_t>(i % 1000), "SYM"});
+        }
+    };
+
+    std::cout << "\n" << n << " records, " << (n * sizeof(record) >> 20) << " MB\n";
+    report("build", time_ms([&]{
+        std::filesystem::remove(path);
+        persistent_vector<record> v{path};
+        build(v);
+    }, 1));
+    report("reopen", time_ms([&]{
+        persistent_vector<record> v{path};
+        do_not_optimize(v.size());
+    }));
+    report("reopen + read last record", time_ms([&]{
+        persistent_vector<record> v{path};
+        do_not_optimize(v[v.size() - 1].price);
+    }));
+
+    std::filesystem::remove(path);
+}
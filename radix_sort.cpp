@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <iostream>
+
+#include "bench.h"
+#include "functors.h"
+#include "parallel.h"
+
+// Sort keys for comparators of the shape "field a ascending, then field b
+// descending, ...": each integer field becomes an unsigned digit string
+// in the right order (signed fields get their sign bit flipped,
+// descending ones are inverted) and the fields are packed, most
+// significant first, into one uint64. Comparing those keys is comparing
+// with the comparator, and they can be radix sorted.
+template<auto Member>
+struct ascending{
+    static constexpr auto member = Member;
+    static constexpr bool reversed = false;
+};
+
+template<auto Member>
+struct descending{
+    static constexpr auto member = Member;
+    static constexpr bool reversed = true;
+};
+
+namespace detail
+{
+
+    template<typename C, typename M>
+    M member_type(M C::*);
+
+    template<typename Field>
+    using field_t = decltype(member_type(Field::member));
+
+    template<typename Field>
+    inline constexpr unsigned field_bits = std::numeric_limits<std::make_unsigned_t<field_t<Field>>>::digits;
+
+    template<typename Field, typename T>
+    std::uint64_t field_digits(const T& value){
+        using U = std::make_unsigned_t<field_t<Field>>;
+        U u = static_cast<U>(value.*Field::member);
+        if constexpr (std::is_signed_v<field_t<Field>>) u ^= U{1} << (field_bits<Field> - 1);
+        if constexpr (Field::reversed) u = static_cast<U>(~u);
+        return u;
+    }
+
+} // namespace detail
+
+template<typename... Fields>
+struct ordered_key{
+    static constexpr unsigned bits = (detail::field_bits<Fields> + ...);
+    static_assert(bits <= 64, "the fields must fit in a uint64");
+
+    template<typename T>
+    std::uint64_t operator()(const T& value) const {
+        std::uint64_t key = 0;
+        ((key = (key << (detail::field_bits<Fields> - 1) << 1) | detail::field_digits<Fields>(value)), ...);
+        return key;
+    }
+};
+
+// Functor's order: x ascending, then y descending
+using functor_order = ordered_key<ascending<&data::x>, descending<&data::y>>;
+
+namespace detail
+{
+
+    inline constexpr unsigned radix_bits = 11;
+    inline constexpr std::size_t buckets = std::size_t{1} << radix_bits;
+
+    using histogram = std::array<std::size_t, buckets>;
+
+    template<typename KeyOf>
+    constexpr unsigned digit_count = (KeyOf::bits + radix_bits - 1) / radix_bits;
+
+    template<typename T, typename KeyOf>
+    unsigned digit(const T& value, KeyOf key, unsigned d){
+        return static_cast<unsigned>(key(value) >> (d * radix_bits)) & (buckets - 1);
+    }
+
+    // Counts every digit of every key in one read. A digit all keys share
+    // puts n in a single bucket, and its pass can be skipped.
+    template<typename T, typename KeyOf>
+    std::vector<unsigned> passes_needed(std::span<const T> items, KeyOf key){
+        std::array<histogram, digit_count<KeyOf>> counts{};
+        for (const T& x : items){
+            std::uint64_t k = key(x);
+            for (unsigned d=0;d<digit_count<KeyOf>;++d) ++counts[d][(k >> (d * radix_bits)) & (buckets - 1)];
+        }
+
+        std::vector<unsigned> passes;
+        for (unsigned d=0;d<digit_count<KeyOf>;++d){
+            if (std::ranges::find(counts[d], items.size()) == counts[d].end()) passes.push_back(d);
+        }
+        return passes;
+    }
+
+} // namespace detail
+
+// LSD radix sort: one stable counting pass per 11-bit digit of the key,
+// lowest first. O(n) per pass whatever the order of the input, and no
+// comparisons at all. Needs a buffer as big as the input.
+template<typename T, typename KeyOf>
+void radix_sort(std::span<T> items, KeyOf key = {}){
+    std::vector<T> buffer(items.size());
+    T* src = items.data();
+    T* dst = buffer.data();
+
+    for (unsigned d : detail::passes_needed(std::span<const T>{items}, key)){
+        detail::histogram offsets{};
+        for (std::size_t i=0;i<items.size();++i) ++offsets[detail::digit(src[i], key, d)];
+
+        std::size_t sum = 0;
+        for (auto& o : offsets) sum += std::exchange(o, sum);
+
+        for (std::size_t i=0;i<items.size();++i) dst[offsets[detail::digit(src[i], key, d)]++] = src[i];
+        std::swap(src, dst);
+    }
+
+    if (src != items.data()) std::copy(src, src + items.size(), items.data());
+}
+
+// The same with each pass split over the thread pool: every thread counts
+// the digits of its own chunk, the counts give each (chunk, bucket) pair
+// its own slice of the output, and then every thread scatters its chunk
+// into its slices. Chunks keep their order within a bucket, so the sort
+// stays stable.
+template<typename T, typename KeyOf>
+void parallel_radix_sort(std::span<T> items, KeyOf key = {}){
+    auto& pool = parallel::thread_pool::global();
+    std::size_t n = items.size();
+    std::size_t chunks = std::clamp<std::size_t>(n / parallel::default_grain, 1, pool.size());
+    if (chunks == 1) return radix_sort(items, key);
+
+    std::size_t chunk_size = (n + chunks - 1) / chunks;
+    auto chunk_begin = [&](std::size_t c){ return std::min(n, c * chunk_size); };
+
+    std::vector<T> buffer(n);
+    T* src = items.data();
+    T* dst = buffer.data();
+    std::vector<detail::histogram> offsets(chunks);
+
+    for (unsigned d : detail::passes_needed(std::span<const T>{items}, key)){
+        pool.run(chunks, [&](std::size_t c){
+            offsets[c].fill(0);
+            for (std::size_t i=chunk_begin(c);i<chunk_begin(c + 1);++i) ++offsets[c][detail::digit(src[i], key, d)];
+        });
+
+        std::size_t sum = 0;
+        for (std::size_t b=0;b<detail::buckets;++b){
+            for (std::size_t c=0;c<chunks;++c) sum += std::exchange(offsets[c][b], sum);
+        }
+
+        pool.run(chunks, [&](std::size_t c){
+            auto& o = offsets[c];
+            for (std::size_t i=chunk_begin(c);i<chunk_begin(c + 1);++i) dst[o[detail::digit(src[i], key, d)]++] = src[i];
+        });
+        std::swap(src, dst);
+    }
+
+    if (src != items.data()) std::copy(src, src + n, items.data());
+}
+
+int main(int argc, char** argv){
+    std::vector<data> v = {{1, 1}, {0, 1}, {1, 2}, {-3, 7}, {0, 2}, {-3, -7}};
+    radix_sort(std::span{v}, functor_order{});
+    for (const auto& d : v) std::cout << "(" << d.x << ", " << d.y << "), ";
+    std::cout << '\n';
+
+    // The key order is the comparator's order
+    std::mt19937 gen{42};
+    for (int i=0;i<100000;++i){
+        data a{int(gen()), int(gen() % 4)}, b{int(gen() % 2 ? a.x : gen()), int(gen() % 4)};
+        if (Functor{}(a, b) != (functor_order{}(a) < functor_order{}(b))) throw std::logic_error{"key order differs from Functor"};
+    }
+
+    // Benchmark: random records, sorted by each method. std::set is only
+    // timed up to 10M records, past which its nodes don't fit in memory.
+    std::vector<std::size_t> sizes = {1'000'000, 100'000'000};
+    if (argc > 1){
+        sizes.clear();
+        for (int i=1;i<argc;++i) sizes.push_back(std::stoull(argv[i]));
+    }
+
+    for (std::size_t n : sizes){
+        std::vector<data> input(n);
+        for (auto& d : input) d = {int(gen()), int(gen())};
+
+        std::vector<data> expected = input;
+        std::vector<data> work;
+        int reps = n > 10'000'000 ? 1 : 3;
+        std::cout << "\n" << n << " records, " << parallel::thread_pool::global().size() << " threads\n";
+
+        if (n <= 10'000'000){
+            report("std::set insert", time_ms([&]{
+                std::set<data, Functor> s(input.begin(), input.end());
+                do_not_optimize(s.size());
+            }, reps));
+        }
+        report("std::sort", time_ms([&]{
+            expected = input;
+            std::sort(expected.begin(), expected.end(), Functor{});
+        }, reps));
+        report("radix_sort", time_ms([&]{
+            work = input;
+            radix_sort(std::span{work}, functor_order{});
+        }, reps));
+        if (!std::ranges::equal(work, expected, [](const data& a, const data& b){ return a.x == b.x && a.y == b.y; }))
+            throw std::logic_error{"radix_sort disagrees with std::sort"};
+
+        report("parallel_radix_sort", time_ms([&]{
+            work = input;
+            parallel_radix_sort(std::span{work}, functor_order{});
+        }, reps));
+        if (!std::ranges::equal(work, expected, [](const data& a, const data& b){ return a.x == b.x && a.y == b.y; }))
+            throw std::logic_error{"parallel_radix_sort disagrees with std::sort"};
+    }
+}
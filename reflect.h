@@ -0,0 +1,218 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "tuple.h"
+#include "type_name.h"
+
+// Compile-time reflection for aggregates, with no runtime cost and no
+// registration.
+//
+// field_count<T>() probes brace-initialization: `any` converts to any
+// type, so the largest N for which T{any, ..., any} compiles is the number
+// of initializers T takes. Brace elision lets a C array member take one
+// initializer per element, so each field is probed once more with its
+// initializers in braces: T{any..., {any, ...}, any...} only compiles when
+// the braces hold exactly what that field takes (its extent for an array,
+// 1 otherwise).
+//
+// to_tuple() binds the fields with structured bindings and Ties them
+// together. Structured bindings need every member in the same class, so it
+// doesn't work for aggregates with data in their bases (derived in
+// aggregate_initialization.cpp); field_count counts each base as a field.
+namespace reflect
+{
+
+    inline constexpr std::size_t max_fields = 16;
+
+    namespace detail
+    {
+
+        template<std::size_t>
+        struct any{
+            template<typename U>
+            operator U() const;
+        };
+
+        template<typename T, std::size_t... is>
+        constexpr bool constructible(std::index_sequence<is...>){
+            return requires { T{any<is>{}...}; };
+        }
+
+        template<typename T, std::size_t n = 0>
+        constexpr std::size_t initializer_count(){
+            if constexpr (constructible<T>(std::make_index_sequence<n + 1>{})) return initializer_count<T, n + 1>();
+            else return n;
+        }
+
+        // Whether the field starting at initializer i takes exactly m
+        // initializers when they are given in braces
+        template<typename T, std::size_t i, std::size_t m, std::size_t total>
+        constexpr bool takes_braced(){
+            return []<std::size_t... before, std::size_t... inside, std::size_t... after>(
+                std::index_sequence<before...>, std::index_sequence<inside...>, std::index_sequence<after...>){
+                return requires { T{any<before>{}..., {any<inside>{}...}, any<after>{}...}; };
+            }(std::make_index_sequence<i>{}, std::make_index_sequence<m>{}, std::make_index_sequence<total - i - m>{});
+        }
+
+        // Types that can't be initialized from braces at all (std::string
+        // from {any} is ambiguous) take a single initializer
+        template<typename T, std::size_t i, std::size_t total, std::size_t m = 1>
+        constexpr std::size_t field_width(){
+            if constexpr (m > total - i) return 1;
+            else if constexpr (takes_braced<T, i, m, total>()) return m;
+            else return field_width<T, i, total, m + 1>();
+        }
+
+        template<typename T, std::size_t i, std::size_t total>
+        constexpr std::size_t count_fields(){
+            if constexpr (i >= total) return 0;
+            else return 1 + count_fields<T, i + field_width<T, i, total>(), total>();
+        }
+
+    } // namespace detail
+
+    // Aggregates reflected field by field. Arrays and tuple-likes such as
+    // std::array are left out: their elements aren't fields.
+    template<typename T>
+    concept aggregate = std::is_aggregate_v<T> && !std::is_array_v<T> && !requires { std::tuple_size<T>::value; };
+
+    template<aggregate T>
+    constexpr std::size_t field_count(){
+        return detail::count_fields<T, 0, detail::initializer_count<T>()>();
+    }
+
+    // A Tuple of references to the fields of `value`
+    template<typename T>
+        requires aggregate<std::remove_const_t<T>>
+    auto to_tuple(T& value){
+        constexpr std::size_t n = field_count<std::remove_const_t<T>>();
+        static_assert(n <= max_fields, "too many fields to reflect");
+
+        if constexpr (n == 0) { return Tuple<>{}; }
+        else if constexpr (n == 1) { auto& [f0] = value; return Tie(f0); }
+        else if constexpr (n == 2) { auto& [f0, f1] = value; return Tie(f0, f1); }
+        else if constexpr (n == 3) { auto& [f0, f1, f2] = value; return Tie(f0, f1, f2); }
+        else if constexpr (n == 4) { auto& [f0, f1, f2, f3] = value; return Tie(f0, f1, f2, f3); }
+        else if constexpr (n == 5) { auto& [f0, f1, f2, f3, f4] = value; return Tie(f0, f1, f2, f3, f4); }
+        else if constexpr (n == 6) { auto& [f0, f1, f2, f3, f4, f5] = value; return Tie(f0, f1, f2, f3, f4, f5); }
+        else if constexpr (n == 7) { auto& [f0, f1, f2, f3, f4, f5, f6] = value; return Tie(f0, f1, f2, f3, f4, f5, f6); }
+        else if constexpr (n == 8) { auto& [f0, f1, f2, f3, f4, f5, f6, f7] = value; return Tie(f0, f1, f2, f3, f4, f5, f6, f7); }
+        else if constexpr (n == 9) { auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8] = value; return Tie(f0, f1, f2, f3, f4, f5, f6, f7, f8); }
+        else if constexpr (n == 10) { auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9] = value; return Tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9); }
+        else if constexpr (n == 11) { auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10] = value; return Tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10); }
+        else if constexpr (n == 12) { auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11] = value; return Tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11); }
+        else if constexpr (n == 13) { auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12] = value; return Tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12); }
+        else if constexpr (n == 14) { auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13] = value; return Tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13); }
+        else if constexpr (n == 15) { auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14] = value; return Tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14); }
+        else if constexpr (n == 16) { auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15] = value; return Tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15); }
+    }
+
+    template<aggregate T, std::size_t i>
+    using field_type = std::remove_cvref_t<decltype(Get<i>(to_tuple(std::declval<T&>())))>;
+
+    template<aggregate T, std::size_t i>
+    constexpr std::string_view field_type_name(){
+        return type_name<field_type<T, i>>();
+    }
+
+    template<aggregate T>
+    constexpr auto field_type_names(){
+        return []<std::size_t... is>(std::index_sequence<is...>){
+            return std::array<std::string_view, sizeof...(is)>{field_type_name<T, is>()...};
+        }(std::make_index_sequence<field_count<T>()>{});
+    }
+
+    template<aggregate T>
+    bool equal(const T& a, const T& b);
+
+    template<aggregate T>
+    bool less(const T& a, const T& b);
+
+    template<aggregate T>
+    std::size_t hash(const T& value);
+
+    namespace detail
+    {
+
+        // Fields use their own ==, < and std::hash when they have them;
+        // arrays go element by element and nested aggregates recurse
+        template<typename F>
+        bool field_equal(const F& a, const F& b){
+            if constexpr (std::is_array_v<F>) {
+                for (std::size_t k=0;k<std::extent_v<F>;++k){
+                    if (!field_equal(a[k], b[k])) return false;
+                }
+                return true;
+            }
+            else if constexpr (requires { a == b; }) return a == b;
+            else return equal(a, b);
+        }
+
+        template<typename F>
+        bool field_less(const F& a, const F& b){
+            if constexpr (std::is_array_v<F>) {
+                for (std::size_t k=0;k<std::extent_v<F>;++k){
+                    if (field_less(a[k], b[k])) return true;
+                    if (field_less(b[k], a[k])) return false;
+                }
+                return false;
+            }
+            else if constexpr (requires { a < b; }) return a < b;
+            else return less(a, b);
+        }
+
+        inline void hash_combine(std::size_t& seed, std::size_t h){
+            seed ^= h + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+        }
+
+        template<typename F>
+        std::size_t field_hash(const F& value){
+            if constexpr (std::is_array_v<F>) {
+                std::size_t seed = 0;
+                for (const auto& x : value) hash_combine(seed, field_hash(x));
+                return seed;
+            }
+            else if constexpr (requires { std::hash<F>{}(value); }) return std::hash<F>{}(value);
+            else return hash(value);
+        }
+
+    } // namespace detail
+
+    template<aggregate T>
+    bool equal(const T& a, const T& b){
+        auto ta = to_tuple(a);
+        auto tb = to_tuple(b);
+        return [&]<std::size_t... is>(std::index_sequence<is...>){
+            return (detail::field_equal(Get<is>(ta), Get<is>(tb)) && ...);
+        }(std::make_index_sequence<field_count<T>()>{});
+    }
+
+    // Lexicographic, field by field
+    template<aggregate T>
+    bool less(const T& a, const T& b){
+        auto ta = to_tuple(a);
+        auto tb = to_tuple(b);
+        return [&]<std::size_t... is>(std::index_sequence<is...>){
+            int order = 0;
+            ((order = order != 0 ? order
+                    : detail::field_less(Get<is>(ta), Get<is>(tb)) ? -1
+                    : detail::field_less(Get<is>(tb), Get<is>(ta)) ? 1 : 0), ...);
+            return order < 0;
+        }(std::make_index_sequence<field_count<T>()>{});
+    }
+
+    template<aggregate T>
+    std::size_t hash(const T& value){
+        std::size_t seed = 0;
+        ForEach(to_tuple(value), [&](const auto& field) { detail::hash_combine(seed, detail::field_hash(field)); });
+        return seed;
+    }
+
+} // namespace reflect
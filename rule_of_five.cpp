@@ -1,14 +1,21 @@
+#include <random>
+#include <string>
 #include <utility>
 #include <cstring>
+#include <vector>
 #include <iostream>
 
+#include "bench.h"
+
 class rule_of_five
 {
     char* cstring; // raw pointer used as a handle to a dynamically-allocated memory block
 public:
+    static inline bool trace = true; // the benchmark turns the printing off
+
     rule_of_five(const char* s = "") : cstring(nullptr)
     { 
-        std::cout << "Constructor called!\n";
+        if (trace) std::cout << "Constructor called!\n";
         if (s)
         {
             std::size_t n = std::strlen(s) + 1;
@@ -19,29 +26,29 @@ public:
  
     ~rule_of_five()
     {
-        std::cout << "Destructor called!\n";
+        if (trace) std::cout << "Destructor called!\n";
         delete[] cstring; // deallocate
     }
  
     rule_of_five(const rule_of_five& other) // copy constructor
     : rule_of_five(other.cstring) {
-        std::cout << "Copy constructor called!\n";
+        if (trace) std::cout << "Copy constructor called!\n";
     }
  
     rule_of_five(rule_of_five&& other) noexcept // move constructor
     : cstring(std::exchange(other.cstring, nullptr)) {
-        std::cout << "Move constructor called!\n";
+        if (trace) std::cout << "Move constructor called!\n";
     }
  
     rule_of_five& operator=(const rule_of_five& other) // copy assignment
     {
-        std::cout << "Copy assignment operator called!\n";
+        if (trace) std::cout << "Copy assignment operator called!\n";
         return *this = rule_of_five(other); // move assignment called because rule_of_five() is a temporary
     }
  
     rule_of_five& operator=(rule_of_five&& other) noexcept // move assignment
     {
-        std::cout << "Move assignment operator called!\n";
+        if (trace) std::cout << "Move assignment operator called!\n";
         std::swap(cstring, other.cstring);
         return *this;
     }
@@ -54,6 +61,109 @@ public:
 //  }
 };
 
+// The same handle with the copies made cheap: strings of up to 23 chars
+// live inline with no allocation, the length is stored so strlen only
+// runs once, and copy-assignment reuses a heap buffer that is big enough
+// instead of building a temporary. Short vs long is told by the length.
+class sso_string
+{
+    static constexpr std::size_t inline_capacity = 23;
+
+    std::size_t len = 0;
+    union {
+        char buf[inline_capacity + 1];
+        struct {
+            char* ptr;
+            std::size_t cap;
+        } heap;
+    };
+
+    bool is_small() const { return len <= inline_capacity; }
+
+    // Leaves room for n chars and the terminator; keeps nothing
+    void make_room(std::size_t n)
+    {
+        if (n <= inline_capacity)
+        {
+            if (!is_small()) delete[] heap.ptr;
+            len = n;
+            return;
+        }
+        if (!is_small() && heap.cap >= n)
+        {
+            len = n;
+            return;
+        }
+
+        char* fresh = new char[n + 1];
+        if (!is_small()) delete[] heap.ptr;
+        heap.ptr = fresh;
+        heap.cap = n;
+        len = n;
+    }
+
+    void assign(const char* s, std::size_t n)
+    {
+        make_room(n);
+        std::memcpy(data(), s, n);
+        data()[n] = '\0';
+    }
+
+    void steal(sso_string& other) noexcept
+    {
+        len = other.len;
+        if (other.is_small()) std::memcpy(buf, other.buf, len + 1);
+        else heap = other.heap;
+
+        other.len = 0;
+        other.buf[0] = '\0';
+    }
+
+public:
+    sso_string(const char* s = "") : buf{}
+    {
+        if (s) assign(s, std::strlen(s));   // nullptr is the empty string
+    }
+
+    ~sso_string()
+    {
+        if (!is_small()) delete[] heap.ptr;
+    }
+
+    sso_string(const sso_string& other) : buf{}
+    {
+        assign(other.data(), other.len);
+    }
+
+    sso_string(sso_string&& other) noexcept
+    {
+        steal(other);
+    }
+
+    sso_string& operator=(const sso_string& other)
+    {
+        if (this != &other) assign(other.data(), other.len);
+        return *this;
+    }
+
+    sso_string& operator=(sso_string&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (!is_small()) delete[] heap.ptr;
+            steal(other);
+        }
+        return *this;
+    }
+
+    char* data() { return is_small() ? buf : heap.ptr; }
+    const char* data() const { return is_small() ? buf : heap.ptr; }
+    const char* c_str() const { return data(); }
+
+    std::size_t size() const { return len; }
+    std::size_t capacity() const { return is_small() ? inline_capacity : heap.cap; }
+};
+
 rule_of_five foo(){
     std::cout << "foo begin\n";
     rule_of_five rof{"rof_foo"};
@@ -61,6 +171,34 @@ rule_of_five foo(){
     return rof;
 }
 
+// Construct, copy, move and copy-assign n strings, most of them short
+template<typename String>
+void bench_strings(const char* name, const std::vector<std::string>& inputs)
+{
+    std::vector<String> a, b, c;
+    a.reserve(inputs.size());
+    b.reserve(inputs.size());
+    c.reserve(inputs.size());
+
+    std::cout << name << '\n';
+    report("  construct", time_ms([&]{
+        a.clear();
+        for (const auto& s : inputs) a.emplace_back(s.c_str());
+    }));
+    report("  copy", time_ms([&]{
+        b.clear();
+        for (const auto& s : a) b.push_back(s);
+    }));
+    report("  move", time_ms([&]{
+        c.clear();
+        for (auto& s : b) c.push_back(std::move(s));
+        for (auto& s : c) b[&s - c.data()] = std::move(s);
+    }));
+    report("  copy-assign", time_ms([&]{
+        for (std::size_t i=0;i<a.size();++i) c[i] = a[a.size() - 1 - i];
+    }));
+}
+
 int main(){
     rule_of_five rof1{"rof1"};
     rule_of_five rof2{"rof2"};
@@ -74,4 +212,22 @@ int main(){
     auto rof5 = foo();      // nothing gets called because Copy Elision!
     std::cout << "75\n";
     rof5 = foo();       // but it does here! 
-}
\ No newline at end of file
+
+    sso_string none{nullptr};   // empty, like rule_of_five{nullptr}
+    std::cout << none.size() << '\n';
+
+    // Benchmark: 1M strings, 90% of them under 23 chars
+    rule_of_five::trace = false;
+    std::vector<std::string> inputs;
+    std::mt19937 gen{42};
+    for (int i=0;i<1000000;++i)
+    {
+        std::size_t n = gen() % 10 ? 4 + gen() % 18 : 30 + gen() % 60;
+        inputs.emplace_back(n, static_cast<char>('a' + i % 26));
+    }
+
+    std::cout << '\n';
+    bench_strings<rule_of_five>("rule_of_five", inputs);
+    bench_strings<sso_string>("sso_string", inputs);
+    bench_strings<std::string>("std::string", inputs);
+}
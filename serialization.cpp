@@ -0,0 +1,193 @@
+#include <cstdint>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <iostream>
+
+#include "bench.h"
+#include "serialize.h"
+#include "tuple.h"
+
+// The aggregates from aggregate_initialization.cpp: trivially copyable and
+// without padding, so each one packs as a single memcpy
+struct base1 { int b1, b2 = 42; };
+
+struct base2
+{
+    base2() : b3(42) {}
+
+    int b3;
+};
+
+struct derived : base1, base2 { int d; };
+
+struct S
+{
+    int x;
+
+    struct Foo
+    {
+        int i = 2;
+        int j;
+        int a[3];
+    } b;
+};
+
+static_assert(binary::bitwise<base1>() && binary::bitwise<derived>() && binary::bitwise<S>());
+
+// Trivially copyable, but with 3 bytes of padding after `c`: packed field
+// by field in 5 bytes, so the padding never reaches the output
+struct padded{
+    char c;
+    int x;
+};
+
+static_assert(!binary::bitwise<padded>() && binary::fixed_size<padded>() == 5);
+
+// Padding after `side` and a string: written field by field
+struct order{
+    std::uint64_t id;
+    char side;
+    double price;
+    std::int32_t quantity;
+    std::string symbol;
+};
+
+auto Fields(order& o){
+    return Tie(o.id, o.side, o.price, o.quantity, o.symbol);
+}
+
+auto Fields(const order& o){
+    return Tie(o.id, o.side, o.price, o.quantity, o.symbol);
+}
+
+static_assert(!binary::bitwise<order>());
+
+// Declared after order's Fields, which must not claim it
+struct point{
+    int x;
+    int y;
+};
+
+static_assert(binary::bitwise<point>() && !binary::has_fields<point>);
+static_assert(binary::fixed_size<Tuple<int, char, double>>() == 13);
+
+// The same message through iostreams, one stream call per field
+void write_stream(std::ostream& os, const order& o){
+    auto n = static_cast<std::uint32_t>(o.symbol.size());
+    os.write(reinterpret_cast<const char*>(&o.id), sizeof(o.id));
+    os.write(&o.side, sizeof(o.side));
+    os.write(reinterpret_cast<const char*>(&o.price), sizeof(o.price));
+    os.write(reinterpret_cast<const char*>(&o.quantity), sizeof(o.quantity));
+    os.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    os.write(o.symbol.data(), n);
+}
+
+void read_stream(std::istream& is, order& o){
+    std::uint32_t n;
+    is.read(reinterpret_cast<char*>(&o.id), sizeof(o.id));
+    is.read(&o.side, sizeof(o.side));
+    is.read(reinterpret_cast<char*>(&o.price), sizeof(o.price));
+    is.read(reinterpret_cast<char*>(&o.quantity), sizeof(o.quantity));
+    is.read(reinterpret_cast<char*>(&n), sizeof(n));
+    o.symbol.resize(n);
+    is.read(o.symbol.data(), n);
+}
+
+int main(){
+    std::vector<std::byte> buf;
+
+    derived d{{.b1 = 1, .b2 = 2}, {}, 4};
+    binary::pack(d, buf);
+    auto d2 = binary::unpack<derived>(buf);
+    std::cout << buf.size() << ": " << d2.b1 << ' ' << d2.b2 << ' ' << d2.b3 << ' ' << d2.d << '\n';
+
+    buf.clear();
+    S s{1, {2, 3, {4, 5, 6}}};
+    binary::pack(s, buf);
+    std::cout << buf.size() << ": " << binary::unpack<S>(buf).b.a[2] << '\n';
+
+    buf.clear();
+    binary::pack(padded{'p', 7}, buf);
+    std::cout << buf.size() << ": " << binary::unpack<padded>(buf).c << ' ' << binary::unpack<padded>(buf).x << '\n';
+
+    buf.clear();
+    binary::pack(point{3, 4}, buf);
+    std::cout << buf.size() << ": " << binary::unpack<point>(buf).y << '\n';
+
+    buf.clear();
+    Tuple<int, char, double, std::string> t{7, 'x', 2.5, "tuple"};
+    binary::pack(t, buf);
+    binary::view<decltype(t)> tv{buf};
+    std::cout << buf.size() << ": " << Get<0>(tv) << ' ' << Get<2>(tv) << ' ' << Get<3>(tv) << '\n';
+
+    // Read in place: the symbol is a string_view into buf
+    buf.clear();
+    binary::pack(order{42, 'B', 101.25, 300, "ACME"}, buf);
+    binary::view<order> ov{buf};
+    std::string_view symbol = Get<4>(ov);
+    std::cout << ov.size() << ": " << Get<0>(ov) << ' ' << Get<1>(ov) << ' ' << Get<2>(ov) << ' ' << symbol << '\n';
+
+    try {
+        binary::unpack<order>(std::span{buf}.first(buf.size() - 1));
+    }
+    catch (const std::out_of_range& e){
+        std::cout << e.what() << '\n';
+    }
+
+    // Benchmark: a stream of orders encoded and decoded through
+    // iostreams and through the binary layer
+    constexpr std::size_t n = 1 << 20;
+    std::vector<order> orders;
+    for (std::size_t i=0;i<n;++i){
+        orders.push_back({i, i % 2 ? 'B' : 'S', i * 0.25, int(i % 1000), "SYM" + std::to_string(i % 100)});
+    }
+
+    std::string encoded;
+    buf.clear();
+    std::cout << "\n" << n << " orders\n";
+    report("encode iostream", time_ms([&]{
+        std::ostringstream os;
+        for (const auto& o : orders) write_stream(os, o);
+        encoded = std::move(os).str();
+    }));
+    report("encode binary", time_ms([&]{
+        buf.clear();
+        for (const auto& o : orders) binary::pack(o, buf);
+        do_not_optimize(buf.data());
+    }));
+
+    report("decode iostream", time_ms([&]{
+        std::istringstream is{encoded};
+        order o;
+        double total = 0;
+        for (std::size_t i=0;i<n;++i){
+            read_stream(is, o);
+            total += o.price * o.quantity;
+        }
+        do_not_optimize(total);
+    }));
+    report("decode binary::unpack", time_ms([&]{
+        std::span<const std::byte> rest{buf};
+        double total = 0;
+        for (std::size_t i=0;i<n;++i){
+            binary::view<order> v{rest};
+            auto o = v.unpack();
+            total += o.price * o.quantity;
+            rest = rest.subspan(v.size());
+        }
+        do_not_optimize(total);
+    }));
+    report("decode binary::view", time_ms([&]{
+        std::span<const std::byte> rest{buf};
+        double total = 0;
+        for (std::size_t i=0;i<n;++i){
+            binary::view<order> v{rest};
+            total += Get<2>(v) * Get<3>(v);
+            rest = rest.subspan(v.size());
+        }
+        do_not_optimize(total);
+    }));
+}
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "reflect.h"
+#include "tuple.h"
+
+// Binary pack/unpack for Tuples and aggregates.
+//
+// The packed form is the fields one after the other in declaration order,
+// in native byte order, with no padding; strings are a 32-bit length and
+// the characters. When a type is trivially copyable and its fields add up
+// to its size (no padding), that is exactly its memory image, and packing
+// or unpacking it is a single memcpy. Otherwise fields are written one by
+// one into a buffer that was sized up front.
+//
+// Aggregates describe their fields by providing Fields(value), found by
+// ADL, returning a Tie of their members in declaration order. Declare it
+// for the concrete type, const and not: an unconstrained `auto&` overload
+// would claim every other type in the namespace too.
+//
+//     auto Fields(message& m) { return Tie(m.id, m.price, m.name); }
+//     auto Fields(const message& m) { return Tie(m.id, m.price, m.name); }
+//
+// Without one, aggregates that hold a string or have padding get their
+// fields from reflect::to_tuple. Other types without Fields must be
+// padding-free and trivially copyable, and are copied as they are in
+// memory; padding bytes are never written out.
+//
+// Reading doesn't have to copy anything: view<T> reads fields straight out
+// of the buffer, and strings come back as string_views into it.
+namespace binary
+{
+
+    template<typename T>
+    struct is_tuple : std::false_type {};
+
+    template<std::size_t... is, typename... Items>
+    struct is_tuple<FlatTupleImpl<std::index_sequence<is...>, Items...>> : std::true_type {};
+
+    template<typename T>
+    concept string_like = std::same_as<T, std::string> || std::same_as<T, std::string_view>;
+
+    template<typename T>
+    concept has_fields = requires(T& value) { Fields(value); };
+
+    // Whether every byte of a T is part of its value, so that its memory
+    // image holds no uninitialized padding
+    template<typename T>
+    constexpr bool padding_free() {
+        if constexpr (std::is_array_v<T>) return padding_free<std::remove_extent_t<T>>();
+        else return std::has_unique_object_representations_v<T> || (std::is_floating_point_v<T> && sizeof(T) <= sizeof(double));
+    }
+
+    // Aggregates are read through reflection unless their memory image
+    // already is the packed form. Trivially copyable ones included: a
+    // padded POD is exactly the case that needs its fields.
+    template<typename T>
+    concept reflected = reflect::aggregate<T> && !padding_free<T>() && !has_fields<T>;
+
+    // Types packed field by field (unless they turn out to be bitwise)
+    template<typename T>
+    concept structured = is_tuple<T>::value || has_fields<T> || reflected<T>;
+
+    namespace detail
+    {
+
+        template<typename T>
+        decltype(auto) fields_of(T& value) {
+            if constexpr (is_tuple<std::remove_const_t<T>>::value) return (value);
+            else if constexpr (reflected<std::remove_const_t<T>>) return reflect::to_tuple(value);
+            else return Fields(value);
+        }
+
+        template<typename T>
+        using fields_t = std::remove_cvref_t<decltype(fields_of(std::declval<T&>()))>;
+
+        template<typename T, std::size_t i>
+        using field_t = std::remove_cvref_t<decltype(Get<i>(std::declval<fields_t<T>&>()))>;
+
+        template<typename T>
+        inline constexpr std::size_t field_count = TupleSize<fields_t<T>>::value;
+
+        using length_t = std::uint32_t;
+
+    } // namespace detail
+
+    // Size of the packed form of T, or 0 if it depends on the value
+    template<typename T>
+    constexpr std::size_t fixed_size() {
+        if constexpr (string_like<T>) {
+            return 0;
+        }
+        else if constexpr (structured<T>) {
+            return []<std::size_t... is>(std::index_sequence<is...>) -> std::size_t {
+                if (((fixed_size<detail::field_t<T, is>>() == 0) || ...)) return 0;
+                return (fixed_size<detail::field_t<T, is>>() + ... + 0);
+            }(std::make_index_sequence<detail::field_count<T>>{});
+        }
+        else {
+            static_assert(std::is_trivially_copyable_v<T> && padding_free<T>(), "T has padding or isn't trivially copyable: give it a Fields() overload");
+            return sizeof(T);
+        }
+    }
+
+    // Whether the packed form of T is its memory image
+    template<typename T>
+    constexpr bool bitwise() {
+        if constexpr (string_like<T> || !std::is_trivially_copyable_v<T>) return false;
+        else return fixed_size<T>() == sizeof(T);
+    }
+
+    template<typename T>
+    std::size_t packed_size(const T& value) {
+        if constexpr (fixed_size<T>() != 0) {
+            return fixed_size<T>();
+        }
+        else if constexpr (string_like<T>) {
+            // Checked here, before pack writes anything, since the length
+            // goes out as a length_t
+            if (value.size() > std::numeric_limits<detail::length_t>::max())
+                throw std::length_error{"binary: string too long"};
+            return sizeof(detail::length_t) + value.size();
+        }
+        else {
+            std::size_t n = 0;
+            ForEach(detail::fields_of(value), [&](const auto& field) { n += packed_size(field); });
+            return n;
+        }
+    }
+
+    namespace detail
+    {
+
+        // Writes `value` at `out`, which must have room for it, and
+        // returns the end of what was written
+        template<typename T>
+        std::byte* write(const T& value, std::byte* out) {
+            if constexpr (bitwise<T>()) {
+                std::memcpy(out, &value, sizeof(T));
+                return out + sizeof(T);
+            }
+            else if constexpr (string_like<T>) {
+                auto n = static_cast<length_t>(value.size());
+                std::memcpy(out, &n, sizeof(n));
+                std::memcpy(out + sizeof(n), value.data(), n);
+                return out + sizeof(n) + n;
+            }
+            else {
+                ForEach(fields_of(value), [&](const auto& field) { out = write(field, out); });
+                return out;
+            }
+        }
+
+        class reader{
+            public:
+                explicit reader(std::span<const std::byte> bytes)
+                    : p(bytes.data()), end(bytes.data() + bytes.size())
+                {}
+
+                const std::byte* take(std::size_t n) {
+                    if (static_cast<std::size_t>(end - p) < n) throw std::out_of_range{"binary: truncated input"};
+                    const std::byte* at = p;
+                    p += n;
+                    return at;
+                }
+
+            private:
+                const std::byte* p;
+                const std::byte* end;
+        };
+
+        template<typename T>
+        std::string_view read_string(reader& in) {
+            length_t n;
+            std::memcpy(&n, in.take(sizeof(n)), sizeof(n));
+            return {reinterpret_cast<const char*>(in.take(n)), n};
+        }
+
+        template<typename T>
+        void read(T& value, reader& in) {
+            if constexpr (bitwise<T>()) {
+                std::memcpy(&value, in.take(sizeof(T)), sizeof(T));
+            }
+            else if constexpr (string_like<T>) {
+                value = T(read_string<T>(in));
+            }
+            else {
+                ForEach(fields_of(value), [&](auto& field) { read(field, in); });
+            }
+        }
+
+        // Steps over one packed T without decoding it
+        template<typename T>
+        void skip(reader& in) {
+            if constexpr (fixed_size<T>() != 0) {
+                in.take(fixed_size<T>());
+            }
+            else if constexpr (string_like<T>) {
+                read_string<T>(in);
+            }
+            else {
+                [&]<std::size_t... is>(std::index_sequence<is...>) {
+                    (skip<field_t<T, is>>(in), ...);
+                }(std::make_index_sequence<field_count<T>>{});
+            }
+        }
+
+    } // namespace detail
+
+    // Writes `value` into `out` and returns the number of bytes used.
+    // Throws std::length_error if it doesn't fit.
+    template<typename T>
+    std::size_t pack_into(const T& value, std::span<std::byte> out) {
+        std::size_t n = packed_size(value);
+        if (n > out.size()) throw std::length_error{"binary: buffer too small"};
+
+        detail::write(value, out.data());
+        return n;
+    }
+
+    // Appends the packed form of `value` to `out`, sized once up front
+    template<typename T>
+    void pack(const T& value, std::vector<std::byte>& out) {
+        std::size_t at = out.size();
+        out.resize(at + packed_size(value));
+        detail::write(value, out.data() + at);
+    }
+
+    // Decodes a whole T. string_view fields point into `bytes`.
+    template<typename T>
+    T unpack(std::span<const std::byte> bytes) {
+        T value{};
+        detail::reader in{bytes};
+        detail::read(value, in);
+        return value;
+    }
+
+    // A packed T, read in place. Get<i> returns plain fields by value,
+    // strings as string_views into the buffer and structured fields as
+    // nested views.
+    template<typename T>
+    class view{
+        static_assert(structured<T>, "a view reads fields, T has none");
+
+        public:
+            explicit view(std::span<const std::byte> bytes)
+                : bytes(bytes)
+            {}
+
+            std::span<const std::byte> data() const {
+                return bytes;
+            }
+
+            // Bytes taken by the message, which may be followed by others
+            std::size_t size() const {
+                if constexpr (fixed_size<T>() != 0) {
+                    return fixed_size<T>();
+                }
+                else {
+                    detail::reader in{bytes};
+                    detail::skip<T>(in);
+                    return static_cast<std::size_t>(in.take(0) - bytes.data());
+                }
+            }
+
+            T unpack() const {
+                return binary::unpack<T>(bytes);
+            }
+
+        private:
+            std::span<const std::byte> bytes;
+    };
+
+    namespace detail
+    {
+
+        // Offset of field i: a constant while all the fields before it
+        // have a fixed size, otherwise found by skipping over them
+        template<typename T, std::size_t i>
+        std::size_t field_offset(std::span<const std::byte> bytes) {
+            return [&]<std::size_t... ks>(std::index_sequence<ks...>) -> std::size_t {
+                if constexpr (((fixed_size<field_t<T, ks>>() != 0) && ... && true)) {
+                    return (fixed_size<field_t<T, ks>>() + ... + 0);
+                }
+                else {
+                    reader in{bytes};
+                    (skip<field_t<T, ks>>(in), ...);
+                    return static_cast<std::size_t>(in.take(0) - bytes.data());
+                }
+            }(std::make_index_sequence<i>{});
+        }
+
+    } // namespace detail
+
+    template<std::size_t i, typename T>
+    auto Get(const view<T>& v) {
+        using F = detail::field_t<T, i>;
+
+        auto bytes = v.data();
+        detail::reader in{bytes.subspan(std::min(bytes.size(), detail::field_offset<T, i>(bytes)))};
+
+        if constexpr (string_like<F>) {
+            return detail::read_string<F>(in);
+        }
+        else if constexpr (structured<F>) {
+            auto start = in.take(0);
+            detail::skip<F>(in);
+            return view<F>{{start, static_cast<std::size_t>(in.take(0) - start)}};
+        }
+        else {
+            F value;
+            std::memcpy(&value, in.take(sizeof(F)), sizeof(F));
+            return value;
+        }
+    }
+
+} // namespace binary
@@ -0,0 +1,243 @@
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "bench.h"
+#include "vector.h"
+
+// Same interface as vector, but the first N elements live inside the
+// object itself. Only when it overflows does it move to the heap, so
+// containers that stay small never call malloc at all.
+template<typename T, std::size_t N>
+class small_vector{
+    static_assert(N > 0, "use vector<T> if there is no inline storage");
+
+    public:
+        small_vector() = default;
+        small_vector(int n, T m = T{});
+
+        // p points into the object itself when inline, so a memberwise
+        // copy or move would be wrong
+        small_vector(const small_vector&) = delete;
+        small_vector& operator=(const small_vector&) = delete;
+
+        void push_back(const T&);
+        void push_back(T&&);
+
+        void pop_back();
+
+        std::size_t size() const {
+            return sz;
+        }
+
+        std::size_t capacity() const {
+            return cap;
+        }
+
+        bool is_inline() const {
+            return p == inline_data();
+        }
+
+        void print() const {
+            for (std::size_t i=0;i<sz;++i){
+                std::cout << *at(i) << ' ';
+            }
+            std::cout << '\n';
+        }
+
+        ~small_vector();
+
+    private:
+        // Raw storage: there may be no T there yet
+        T* inline_data(){
+            return reinterpret_cast<T*>(buf);
+        }
+
+        const T* inline_data() const {
+            return reinterpret_cast<const T*>(buf);
+        }
+
+        // Element i, which must be alive
+        T* at(std::size_t i){
+            return std::launder(p + i);
+        }
+
+        const T* at(std::size_t i) const {
+            return std::launder(p + i);
+        }
+
+        template<typename... Args>
+        void realloc_append(Args&&... args);
+
+        alignas(T) unsigned char buf[N * sizeof(T)];
+        T* p = inline_data();
+        std::size_t cap = N;
+        std::size_t sz = 0;
+};
+
+template<typename T, std::size_t N>
+small_vector<T, N>::small_vector(int n, T m)
+{
+    if (static_cast<std::size_t>(n) > N){
+        p = static_cast<T*>(std::malloc(n * sizeof(T)));
+        if (!p) throw std::bad_alloc{};
+        cap = n;
+    }
+
+    try {
+        std::uninitialized_fill_n(p, n, m);
+    }
+    catch (...){
+        if (!is_inline()) std::free(p);
+        throw;
+    }
+    sz = n;
+}
+
+template<typename T, std::size_t N>
+small_vector<T, N>::~small_vector(){
+    for (std::size_t i=0;i<sz;++i){
+        at(i)->~T();
+    }
+
+    if (!is_inline()) std::free(p);
+}
+
+// Called once the current storage is full, inline or not. Elements are
+// relocated the same way vector does it (see detail::relocate).
+template<typename T, std::size_t N>
+template<typename... Args>
+void small_vector<T, N>::realloc_append(Args&&... args){
+    std::size_t new_cap = cap * 2;
+    T* q = static_cast<T*>(std::malloc(new_cap * sizeof(T)));
+    if (!q) throw std::bad_alloc{};
+
+    try {
+        new(q + sz) T{std::forward<Args>(args)...};
+    }
+    catch (...){
+        std::free(q);
+        throw;
+    }
+
+    try {
+        detail::relocate(p, sz, q);
+    }
+    catch (...){
+        (q + sz)->~T();
+        std::free(q);
+        throw;
+    }
+
+    if (!is_inline()) std::free(p);
+    p = q;
+    cap = new_cap;
+    ++sz;
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::push_back(const T& x){
+    if (sz == cap){
+        realloc_append(x);
+        return;
+    }
+
+    new(p + sz) T{x};
+    ++sz;
+}
+
+template<typename T, std::size_t N>
+void small_vector<T, N>::push_back(T&& x){
+    if (sz == cap){
+        realloc_append(std::move(x));
+        return;
+    }
+
+    new(p + sz) T{std::move(x)};
+    ++sz;
+}
+
+// Unlike vector, capacity is never given back: a small_vector is meant
+// to be short-lived, and shrinking would only trade memory for reallocs
+template<typename T, std::size_t N>
+void small_vector<T, N>::pop_back(){
+    --sz;
+    at(sz)->~T();
+}
+
+// Its copy constructor throws on the third copy
+struct fragile{
+    static inline int copies = 0;
+    std::string s = "long enough to be on the heap, so a leak shows";
+
+    fragile() = default;
+
+    fragile(const fragile& other) : s(other.s){
+        if (++copies == 3) throw std::runtime_error{"copy failed"};
+    }
+};
+
+// Builds `iters` containers of `n` ints each, the way a per-request
+// container is used: construct, fill, read, throw away
+template<typename Container>
+double bench_fill(int iters, int n){
+    return time_ms([&]{
+        long long total = 0;
+        for (int it=0;it<iters;++it){
+            Container c(1, it);
+            for (int i=1;i<n;++i) c.push_back(i);
+            total += c.size();
+        }
+        do_not_optimize(total);
+    });
+}
+
+int main(){
+    small_vector<int, 4> v1{2};
+    small_vector<int, 4> v2{4, 2};
+
+    v1.print();
+    v2.print();
+
+    v1.push_back(2);
+    v1.push_back(515);
+    std::cout << v1.size() << ' ' << v1.capacity() << ' ' << v1.is_inline() << '\n';
+    v1.push_back(151);      // fifth element, moves to the heap
+    std::cout << v1.size() << ' ' << v1.capacity() << ' ' << v1.is_inline() << '\n';
+    v1.print();
+
+    v1.pop_back();
+    v1.pop_back();
+    v1.print();
+    std::cout << v1.size() << ' ' << v1.capacity() << '\n';
+
+    small_vector<std::string, 2> v3;
+    v3.push_back("inline");
+    v3.push_back("still inline");
+    v3.push_back("a string long enough to live on the heap");
+    v3.print();
+
+    // A throwing copy part way through: the copies already made and the
+    // heap buffer are freed, not leaked
+    try {
+        small_vector<fragile, 2> broken{5};
+    }
+    catch (const std::runtime_error& e){
+        std::cout << e.what() << '\n';
+    }
+
+    // Benchmark: one million short-lived containers. vector and std::vector
+    // both start with a single element, since vector can't start empty.
+    constexpr int iters = 1'000'000;
+    for (int n : {4, 8, 16}){
+        std::cout << "\n" << n << " elements\n";
+        report("vector<int>", bench_fill<vector<int>>(iters, n));
+        report("std::vector<int>", bench_fill<std::vector<int>>(iters, n));
+        report("small_vector<int, 8>", bench_fill<small_vector<int, 8>>(iters, n));
+    }
+}
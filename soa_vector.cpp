@@ -0,0 +1,243 @@
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <iostream>
+
+#include "bench.h"
+#include "tuple.h"
+#include "vector.h"
+
+// Structure of arrays: a vector of records stored as one contiguous
+// array per field. A loop that only reads a couple of fields streams just
+// those arrays through the cache, and each column is a plain array the
+// compiler can vectorize.
+//
+// The column pointers are themselves a Tuple<Items*...>, so Get<i> on
+// the container and on a row both come from the same Tuple machinery.
+template<typename... Items>
+class soa_vector{
+    static_assert((std::is_nothrow_move_constructible_v<Items> && ...),
+                  "columns are relocated on growth and that must not throw");
+
+    public:
+        // A row is a Tuple of references into the columns
+        using row = Tuple<Items&...>;
+
+        soa_vector() = default;
+
+        soa_vector(const soa_vector&) = delete;
+        soa_vector& operator=(const soa_vector&) = delete;
+
+        ~soa_vector();
+
+        void push_back(const Items&... items);
+        void pop_back();
+
+        void reserve(std::size_t n);
+
+        std::size_t size() const {
+            return sz;
+        }
+
+        std::size_t capacity() const {
+            return cap;
+        }
+
+        row operator[](std::size_t i){
+            return row_at(i, std::index_sequence_for<Items...>{});
+        }
+
+        // The whole i-th column
+        template<std::size_t i>
+        auto column(){
+            return std::span{Get<i>(columns), sz};
+        }
+
+    private:
+        using column_pointers = Tuple<Items*...>;
+
+        template<std::size_t... is>
+        row row_at(std::size_t i, std::index_sequence<is...>){
+            return Tie(Get<is>(columns)[i]...);
+        }
+
+        template<std::size_t... is>
+        static void construct(column_pointers& cols, std::size_t pos, std::index_sequence<is...>, const Items&... items);
+
+        template<std::size_t... is>
+        static column_pointers allocate_columns(std::size_t n, std::index_sequence<is...>);
+
+        // Moves the elements into `fresh` and frees the old columns
+        template<std::size_t... is>
+        void adopt(column_pointers fresh, std::size_t new_cap, std::index_sequence<is...>);
+
+        template<std::size_t... is>
+        void destroy(std::index_sequence<is...>);
+
+        column_pointers columns{};
+        std::size_t cap = 0;
+        std::size_t sz = 0;
+};
+
+template<std::size_t i, typename... Items>
+auto Get(soa_vector<Items...>& v){
+    return v.template column<i>();
+}
+
+template<typename... Items>
+soa_vector<Items...>::~soa_vector(){
+    destroy(std::index_sequence_for<Items...>{});
+}
+
+template<typename... Items>
+template<std::size_t... is>
+void soa_vector<Items...>::destroy(std::index_sequence<is...>){
+    ((std::destroy_n(Get<is>(columns), sz), std::free(Get<is>(columns))), ...);
+}
+
+// Builds one field in every column at `pos`. If a constructor throws the
+// fields already built are destroyed again.
+template<typename... Items>
+template<std::size_t... is>
+void soa_vector<Items...>::construct(column_pointers& cols, std::size_t pos, std::index_sequence<is...>, const Items&... items){
+    std::size_t built = 0;
+    try {
+        ((new(Get<is>(cols) + pos) Items(items), ++built), ...);
+    }
+    catch (...){
+        ((is < built ? Get<is>(cols)[pos].~Items() : void()), ...);
+        throw;
+    }
+}
+
+// All columns are allocated before anything is moved, so running out
+// of memory leaves the vector as it was
+template<typename... Items>
+template<std::size_t... is>
+typename soa_vector<Items...>::column_pointers soa_vector<Items...>::allocate_columns(std::size_t n, std::index_sequence<is...>){
+    column_pointers fresh{};
+    bool ok = ((Get<is>(fresh) = static_cast<Items*>(std::malloc(n * sizeof(Items)))) && ...);
+    if (!ok){
+        (std::free(Get<is>(fresh)), ...);
+        throw std::bad_alloc{};
+    }
+    return fresh;
+}
+
+template<typename... Items>
+template<std::size_t... is>
+void soa_vector<Items...>::adopt(column_pointers fresh, std::size_t new_cap, std::index_sequence<is...>){
+    ((detail::relocate(Get<is>(columns), sz, Get<is>(fresh)), std::free(Get<is>(columns))), ...);
+    columns = fresh;
+    cap = new_cap;
+}
+
+template<typename... Items>
+void soa_vector<Items...>::push_back(const Items&... items){
+    constexpr auto fields = std::index_sequence_for<Items...>{};
+
+    if (sz < cap){
+        construct(columns, sz, fields, items...);
+        ++sz;
+        return;
+    }
+
+    // `items` may refer into the old columns, so the new row is built in
+    // the new columns before the old ones go away
+    std::size_t new_cap = default_growth_policy::grow(cap);
+    column_pointers fresh = allocate_columns(new_cap, fields);
+    try {
+        construct(fresh, sz, fields, items...);
+    }
+    catch (...){
+        [&]<std::size_t... is>(std::index_sequence<is...>){
+            (std::free(Get<is>(fresh)), ...);
+        }(fields);
+        throw;
+    }
+
+    adopt(fresh, new_cap, fields);
+    ++sz;
+}
+
+template<typename... Items>
+void soa_vector<Items...>::pop_back(){
+    --sz;
+    [&]<std::size_t... is>(std::index_sequence<is...>){
+        (Get<is>(columns)[sz].~Items(), ...);
+    }(std::index_sequence_for<Items...>{});
+}
+
+template<typename... Items>
+void soa_vector<Items...>::reserve(std::size_t n){
+    constexpr auto fields = std::index_sequence_for<Items...>{};
+    if (n > cap) adopt(allocate_columns(n, fields), n, fields);
+}
+
+// A wide record where most scans only need one or two fields
+struct data{
+    int x;
+    int y;
+    double weight;
+    long long timestamp;
+    char tag[16];
+};
+
+int main(){
+    soa_vector<int, double, std::string> v;
+    v.push_back(1, 0.5, "one");
+    v.push_back(2, 1.5, "two");
+    v.push_back(3, 2.5, "three");
+
+    auto r = v[1];
+    Get<0>(r) = 20;                 // writes through to the column
+    std::cout << Get<0>(r) << ' ' << Get<1>(r) << ' ' << Get<2>(r) << '\n';
+
+    for (int x : Get<0>(v)) std::cout << x << ' ';
+    std::cout << '\n';
+
+    v.pop_back();
+    std::cout << v.size() << ' ' << v.capacity() << '\n';
+
+    // Benchmark: the same records as an array of structs and as columns
+    constexpr std::size_t n = 1 << 22;
+    std::vector<data> aos;
+    soa_vector<int, int, double, long long, std::array<char, 16>> soa;
+    aos.reserve(n);
+    soa.reserve(n);
+    for (std::size_t i=0;i<n;++i){
+        aos.push_back({int(i), int(i % 7), i * 0.25, (long long)i, "tag"});
+        soa.push_back(int(i), int(i % 7), i * 0.25, (long long)i, {'t', 'a', 'g'});
+    }
+
+    std::cout << "\n" << n << " records of " << sizeof(data) << " bytes\n";
+    report("AoS sum x", time_ms([&]{
+        long long s = 0;
+        for (const auto& d : aos) s += d.x;
+        do_not_optimize(s);
+    }));
+    report("SoA sum x", time_ms([&]{
+        long long s = 0;
+        for (int x : Get<0>(soa)) s += x;
+        do_not_optimize(s);
+    }));
+    report("AoS sum x * weight", time_ms([&]{
+        double s = 0;
+        for (const auto& d : aos) s += d.x * d.weight;
+        do_not_optimize(s);
+    }));
+    report("SoA sum x * weight", time_ms([&]{
+        auto xs = Get<0>(soa);
+        auto ws = Get<2>(soa);
+        double s = 0;
+        for (std::size_t i=0;i<xs.size();++i) s += xs[i] * ws[i];
+        do_not_optimize(s);
+    }));
+}
@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <new>
+#include <random>
+#include <set>
+#include <span>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+#include "bench.h"
+#include "functors.h"
+
+// Read-only search indexes over a sorted range. They copy the keys into a
+// layout where a search touches few cache lines, and answer with positions
+// in the original range, which the caller keeps.
+//
+// Keys are compared as int64s, so KeyOf must map elements to int64s in
+// the same order as the range is sorted. For data and Functor (x
+// ascending, y descending) that is x in the high half and y, flipped, in
+// the low half.
+struct functor_key{
+    std::int64_t operator()(const data& d) const {
+        std::uint32_t y_descending = static_cast<std::uint32_t>(d.y) ^ 0x7fffffffu;
+        return static_cast<std::int64_t>(static_cast<std::uint64_t>(static_cast<std::int64_t>(d.x)) << 32 | y_descending);
+    }
+};
+
+// int64 arrays aligned to cache lines
+struct aligned_free{
+    void operator()(std::int64_t* p) const {
+        std::free(p);
+    }
+};
+
+using aligned_keys = std::unique_ptr<std::int64_t[], aligned_free>;
+
+inline aligned_keys allocate_keys(std::size_t n){
+    std::size_t bytes = (n * sizeof(std::int64_t) + 63) / 64 * 64;
+    auto p = static_cast<std::int64_t*>(std::aligned_alloc(64, std::max<std::size_t>(bytes, 64)));
+    if (!p) throw std::bad_alloc{};
+    return aligned_keys{p};
+}
+
+// Search interface shared by both indexes, on top of Derived::position
+template<typename Derived, typename T, typename KeyOf>
+class search_index{
+    public:
+        // First element not less than `value`, or end()
+        const T* lower_bound(const T& value) const {
+            return sorted.data() + self().position(KeyOf{}(value));
+        }
+
+        const T* find(const T& value) const {
+            const T* it = lower_bound(value);
+            return it != end() && KeyOf{}(*it) == KeyOf{}(value) ? it : end();
+        }
+
+        // Elements in [lo, hi)
+        std::span<const T> range(const T& lo, const T& hi) const {
+            const T* first = lower_bound(lo);
+            return {first, std::max(first, lower_bound(hi))};
+        }
+
+        const T* end() const {
+            return sorted.data() + sorted.size();
+        }
+
+    protected:
+        explicit search_index(std::span<const T> sorted)
+            : sorted(sorted)
+        {}
+
+        std::span<const T> sorted;
+
+    private:
+        const Derived& self() const {
+            return static_cast<const Derived&>(*this);
+        }
+};
+
+// The keys in Eytzinger (BFS) order: node k's children are 2k and 2k+1,
+// so the top of the tree is packed into the first few cache lines, and
+// the 8 descendants three levels down share one line, which is prefetched
+// while the next three levels are compared. The descent has no branches
+// to mispredict.
+template<typename T, typename KeyOf>
+class eytzinger_index : public search_index<eytzinger_index<T, KeyOf>, T, KeyOf>{
+    using base = search_index<eytzinger_index<T, KeyOf>, T, KeyOf>;
+
+    public:
+        explicit eytzinger_index(std::span<const T> sorted)
+            : base(sorted), n(sorted.size()), keys(allocate_keys(n + 1)), ranks(n + 1)
+        {
+            std::size_t i = 0;
+            build(i, 1);
+            ranks[0] = n;
+        }
+
+        std::size_t position(std::int64_t key) const {
+            std::size_t k = 1;
+            while (k <= n){
+                __builtin_prefetch(keys.get() + k * 8);
+                k = 2 * k + (keys[k] < key);
+            }
+            // Undo the right turns taken after the last left one
+            k >>= std::countr_one(k) + 1;
+            return ranks[k];
+        }
+
+    private:
+        // In-order walk of the implicit tree hands out the sorted keys
+        void build(std::size_t& i, std::size_t k){
+            if (k > n) return;
+            build(i, 2 * k);
+            keys[k] = KeyOf{}(this->sorted[i]);
+            ranks[k] = i++;
+            build(i, 2 * k + 1);
+        }
+
+        std::size_t n;
+        aligned_keys keys;
+        std::vector<std::size_t> ranks;      // slot -> position in the range
+};
+
+// Number of keys in an 8-key node that are less than x. The keys are
+// sorted, so counting the matches of one compare is the rank. Which
+// version is used depends on the build flags (-mavx2, -msse4.2 or
+// -march=native); without them it is a scalar loop.
+inline unsigned node_rank(const std::int64_t* node, std::int64_t x){
+#if defined(__AVX2__)
+    __m256i v = _mm256_set1_epi64x(x);
+    __m256i lo = _mm256_cmpgt_epi64(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(node)));
+    __m256i hi = _mm256_cmpgt_epi64(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(node + 4)));
+    unsigned mask = _mm256_movemask_pd(_mm256_castsi256_pd(lo)) | _mm256_movemask_pd(_mm256_castsi256_pd(hi)) << 4;
+    return std::popcount(mask);
+#elif defined(__SSE4_2__)
+    __m128i v = _mm_set1_epi64x(x);
+    unsigned count = 0;
+    for (int j=0;j<8;j+=2){
+        __m128i lt = _mm_cmpgt_epi64(v, _mm_load_si128(reinterpret_cast<const __m128i*>(node + j)));
+        count += std::popcount(static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(lt))));
+    }
+    return count;
+#else
+    unsigned count = 0;
+    for (int j=0;j<8;++j) count += node[j] < x;
+    return count;
+#endif
+}
+
+// A static B+-tree with one 64-byte line per node: 8 keys and 9 children,
+// found by arithmetic rather than pointers. The leaves are the sorted
+// keys themselves, so the rank in the last node is the answer. Each
+// level is one cache miss and one SIMD compare of the whole node,
+// against log2(8) levels of a binary search.
+template<typename T, typename KeyOf>
+class btree_index : public search_index<btree_index<T, KeyOf>, T, KeyOf>{
+    using base = search_index<btree_index<T, KeyOf>, T, KeyOf>;
+
+    public:
+        static constexpr std::size_t B = 8;
+
+        explicit btree_index(std::span<const T> sorted);
+
+        std::size_t position(std::int64_t key) const {
+            std::size_t k = 0;      // node index within the level
+            for (std::size_t h=offsets.size()-1;h>0;--h){
+                k = k * (B + 1) + node_rank(keys.get() + offsets[h] + k * B, key);
+            }
+            return std::min(k * B + node_rank(keys.get() + k * B, key), this->sorted.size());
+        }
+
+    private:
+        static constexpr std::int64_t pad = std::numeric_limits<std::int64_t>::max();
+
+        aligned_keys keys;
+        std::vector<std::size_t> offsets;   // first key of each level, leaves first
+};
+
+template<typename T, typename KeyOf>
+btree_index<T, KeyOf>::btree_index(std::span<const T> sorted)
+    : base(sorted)
+{
+    std::size_t n = sorted.size();
+    std::vector<std::size_t> nodes{std::max<std::size_t>((n + B - 1) / B, 1)};
+    while (nodes.back() > 1) nodes.push_back((nodes.back() + B) / (B + 1));
+
+    std::size_t total = 0;
+    for (std::size_t count : nodes){
+        offsets.push_back(total);
+        total += count * B;
+    }
+    keys = allocate_keys(total);
+
+    for (std::size_t i=0;i<nodes[0]*B;++i) keys[i] = i < n ? KeyOf{}(sorted[i]) : pad;
+
+    // Key j of an inner node is the smallest key under its child j + 1:
+    // the first leaf key of that subtree
+    std::size_t span = 1;       // leaves under one node of the level below
+    for (std::size_t h=1;h<nodes.size();++h){
+        for (std::size_t i=0;i<nodes[h]*B;++i){
+            std::size_t child = i / B * (B + 1) + i % B + 1;
+            std::size_t leaf = child * span;
+            keys[offsets[h] + i] = leaf * B < n ? keys[leaf * B] : pad;
+        }
+        span *= B + 1;
+    }
+}
+
+template<typename Index>
+void check(const Index& index, const std::vector<data>& sorted, const std::vector<data>& probes){
+    for (const auto& p : probes){
+        auto expected = std::lower_bound(sorted.begin(), sorted.end(), p, Functor{});
+        if (index.lower_bound(p) != sorted.data() + (expected - sorted.begin())) throw std::logic_error{"index disagrees with std::lower_bound"};
+    }
+}
+
+template<typename F>
+void bench_lookups(const char* name, const std::vector<data>& probes, F lower_bound){
+    report(name, time_ms([&]{
+        long long s = 0;
+        for (const auto& p : probes) s += lower_bound(p);
+        do_not_optimize(s);
+    }, 3));
+}
+
+int main(int argc, char** argv){
+    std::vector<data> small = {{1, 9}, {1, 3}, {2, 5}, {4, 4}, {4, 1}, {7, 0}};
+    eytzinger_index<data, functor_key> e{small};
+    btree_index<data, functor_key> b{small};
+    std::cout << (e.find({4, 1}) - small.data()) << ' ' << (b.find({4, 1}) - small.data()) << ' '
+              << (b.find({3, 0}) == b.end()) << ' ' << b.range({1, 5}, {4, 2}).size() << '\n';
+
+    // Benchmark: 1M lookups, half of them hits, at each size. Pass sizes
+    // on the command line to override; std::set is left out past 10M
+    // keys, where its nodes alone would be ~5 GB at 100M.
+    std::vector<std::size_t> sizes = {10'000, 1'000'000, 100'000'000};
+    if (argc > 1){
+        sizes.clear();
+        for (int i=1;i<argc;++i) sizes.push_back(std::stoull(argv[i]));
+    }
+
+    std::mt19937_64 gen{42};
+    for (std::size_t n : sizes){
+        std::vector<data> sorted(n);
+        for (auto& d : sorted) d = {int(gen() % (n + 1)), int(gen())};
+        std::sort(sorted.begin(), sorted.end(), Functor{});
+
+        std::vector<data> probes(1 << 20);
+        for (std::size_t i=0;i<probes.size();++i){
+            probes[i] = i % 2 ? sorted[gen() % n] : data{int(gen() % (n + 1)), int(gen())};
+        }
+
+        std::cout << "\n" << n << " keys\n";
+        bench_lookups("std::lower_bound", probes, [&](const data& p){
+            return std::lower_bound(sorted.begin(), sorted.end(), p, Functor{}) - sorted.begin();
+        });
+        if (n <= 10'000'000){
+            std::set<data, Functor> tree(sorted.begin(), sorted.end());
+            bench_lookups("std::set", probes, [&](const data& p){
+                return tree.lower_bound(p) != tree.end();
+            });
+        }
+        {
+            eytzinger_index<data, functor_key> index{sorted};
+            check(index, sorted, std::vector<data>(probes.begin(), probes.begin() + 1000));
+            bench_lookups("eytzinger_index", probes, [&](const data& p){
+                return index.lower_bound(p) - sorted.data();
+            });
+        }
+        {
+            btree_index<data, functor_key> index{sorted};
+            check(index, sorted, std::vector<data>(probes.begin(), probes.begin() + 1000));
+            bench_lookups("btree_index", probes, [&](const data& p){
+                return index.lower_bound(p) - sorted.data();
+            });
+        }
+    }
+}
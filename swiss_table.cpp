@@ -0,0 +1,419 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <iostream>
+
+#include <emmintrin.h>
+
+#include "bench.h"
+#include "functors.h"
+
+// The hash the tables use unless given another. The default for data
+// packs both fields into one word; anything else goes to std::hash.
+template<typename T>
+struct hasher : std::hash<T>{};
+
+template<>
+struct hasher<data>{
+    std::size_t operator()(const data& d) const {
+        std::uint64_t packed = static_cast<std::uint64_t>(static_cast<std::uint32_t>(d.x)) << 32 | static_cast<std::uint32_t>(d.y);
+        return std::hash<std::uint64_t>{}(packed);
+    }
+};
+
+// Likewise for equality: data has no operator==
+template<typename T>
+struct key_equal : std::equal_to<T>{};
+
+template<>
+struct key_equal<data>{
+    bool operator()(const data& a, const data& b) const {
+        return a.x == b.x && a.y == b.y;
+    }
+};
+
+namespace detail
+{
+
+    // One control byte per slot: 0x80 for empty, else the low 7 bits of
+    // the slot's hash. The high bit alone tells empty from full.
+    inline constexpr std::int8_t empty = static_cast<std::int8_t>(0x80);
+    inline constexpr std::size_t group_width = 16;
+
+    // Bit i set when control byte i of the 16 at `ctrl` matches
+    struct group{
+        __m128i ctrl;
+
+        explicit group(const std::int8_t* p)
+            : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)))
+        {}
+
+        unsigned match(std::int8_t h2) const {
+            return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2))));
+        }
+
+        unsigned match_empty() const {
+            return static_cast<unsigned>(_mm_movemask_epi8(ctrl));
+        }
+    };
+
+    template<typename Key>
+    const Key& key_of(const Key& key){
+        return key;
+    }
+
+    template<typename Key, typename Value>
+    const Key& key_of(const std::pair<const Key, Value>& slot){
+        return slot.first;
+    }
+
+} // namespace detail
+
+// An open-addressing hash table after the Swiss table layout: slots in
+// one flat array and a parallel array of control bytes, 16 of which are
+// compared against a hash's 7-bit tag with one SSE2 instruction, so most
+// lookups touch one line of control bytes and then only the slot that
+// matches. There is no node per element.
+//
+// Probing is linear by slot, 16 at a time (the first 15 control bytes
+// are mirrored past the end, so a group never wraps). Linear probing
+// lets erase shift the following elements back instead of leaving a
+// tombstone, so the table never fills with deleted slots and never needs
+// a rehash to clean them up. The load factor is kept under 7/8.
+template<typename Key, typename Slot, typename Hash, typename Equal>
+class swiss_table{
+    public:
+        explicit swiss_table(Hash hash = Hash{}, Equal equal = Equal{})
+            : hash(hash), equal(equal)
+        {}
+
+        swiss_table(const swiss_table&) = delete;
+        swiss_table& operator=(const swiss_table&) = delete;
+
+        swiss_table(swiss_table&& other) noexcept
+            : ctrl(std::exchange(other.ctrl, nullptr)), slots(std::exchange(other.slots, nullptr)),
+              cap(std::exchange(other.cap, 0)), sz(std::exchange(other.sz, 0)),
+              hash(other.hash), equal(other.equal)
+        {}
+
+        swiss_table& operator=(swiss_table&& other) noexcept {
+            std::swap(ctrl, other.ctrl);
+            std::swap(slots, other.slots);
+            std::swap(cap, other.cap);
+            std::swap(sz, other.sz);
+            std::swap(hash, other.hash);
+            std::swap(equal, other.equal);
+            return *this;
+        }
+
+        ~swiss_table(){
+            clear();
+            release();
+        }
+
+        Slot* find(const Key& key) const {
+            if (sz == 0) return nullptr;
+            std::size_t i = index_of(key, mix(hash(key)));
+            return i == npos ? nullptr : slots + i;
+        }
+
+        bool contains(const Key& key) const {
+            return find(key) != nullptr;
+        }
+
+        template<typename... Args>
+        std::pair<Slot*, bool> emplace(const Key& key, Args&&... args);
+
+        bool erase(const Key& key);
+
+        // Room for n elements without rehashing
+        void reserve(std::size_t n){
+            std::size_t needed = std::bit_ceil(std::max<std::size_t>(n + (n + 6) / 7, detail::group_width));
+            if (needed > cap) rehash(needed);
+        }
+
+        void clear();
+
+        std::size_t size() const {
+            return sz;
+        }
+
+        std::size_t capacity() const {
+            return cap;
+        }
+
+        double load_factor() const {
+            return cap ? static_cast<double>(sz) / cap : 0;
+        }
+
+        template<typename F>
+        void for_each(F f) const {
+            for (std::size_t i=0;i<cap;++i){
+                if (ctrl[i] != detail::empty) f(slots[i]);
+            }
+        }
+
+    private:
+        static constexpr std::size_t npos = -1;
+
+        // Home slot and tag both come from a few bits of the hash, and
+        // std::hash for integers is the identity, so every bit is mixed
+        // in first: the two halves of a 128-bit product, folded
+        static std::uint64_t mix(std::uint64_t h){
+            unsigned __int128 p = static_cast<unsigned __int128>(h) * 0x9e3779b97f4a7c15ull;
+            return static_cast<std::uint64_t>(p) ^ static_cast<std::uint64_t>(p >> 64);
+        }
+
+        std::size_t home(std::uint64_t h) const {
+            return (h >> 7) & (cap - 1);
+        }
+
+        static std::int8_t tag(std::uint64_t h){
+            return static_cast<std::int8_t>(h & 0x7f);
+        }
+
+        std::size_t index_of(const Key& key, std::uint64_t h) const;
+        std::size_t first_empty(std::uint64_t h) const;
+
+        void set_ctrl(std::size_t i, std::int8_t c){
+            ctrl[i] = c;
+            if (i < detail::group_width - 1) ctrl[cap + i] = c;
+        }
+
+        void rehash(std::size_t new_cap);
+
+        void release(){
+            ::operator delete(slots, std::align_val_t{alignof(Slot)});
+            delete[] ctrl;
+        }
+
+        std::int8_t* ctrl = nullptr;        // cap + 15 bytes
+        Slot* slots = nullptr;
+        std::size_t cap = 0;
+        std::size_t sz = 0;
+        [[no_unique_address]] Hash hash;
+        [[no_unique_address]] Equal equal;
+};
+
+template<typename Key, typename Slot, typename Hash, typename Equal>
+std::size_t swiss_table<Key, Slot, Hash, Equal>::index_of(const Key& key, std::uint64_t h) const {
+    std::int8_t t = tag(h);
+    for (std::size_t pos=home(h);;pos=(pos + detail::group_width) & (cap - 1)){
+        detail::group g{ctrl + pos};
+        for (unsigned m=g.match(t);m;m&=m-1){
+            std::size_t i = (pos + std::countr_zero(m)) & (cap - 1);
+            if (equal(detail::key_of(slots[i]), key)) return i;
+        }
+        // Runs from a home slot have no holes, so an empty ends the search
+        if (g.match_empty()) return npos;
+    }
+}
+
+template<typename Key, typename Slot, typename Hash, typename Equal>
+std::size_t swiss_table<Key, Slot, Hash, Equal>::first_empty(std::uint64_t h) const {
+    for (std::size_t pos=home(h);;pos=(pos + detail::group_width) & (cap - 1)){
+        if (unsigned m = detail::group{ctrl + pos}.match_empty()) return (pos + std::countr_zero(m)) & (cap - 1);
+    }
+}
+
+template<typename Key, typename Slot, typename Hash, typename Equal>
+template<typename... Args>
+std::pair<Slot*, bool> swiss_table<Key, Slot, Hash, Equal>::emplace(const Key& key, Args&&... args){
+    std::uint64_t h = mix(hash(key));
+    if (sz){
+        std::size_t i = index_of(key, h);
+        if (i != npos) return {slots + i, false};
+    }
+    if (sz + 1 > cap - cap / 8) rehash(std::max(2 * cap, detail::group_width));
+
+    std::size_t i = first_empty(h);
+    ::new (slots + i) Slot(std::forward<Args>(args)...);
+    set_ctrl(i, tag(h));
+    ++sz;
+    return {slots + i, true};
+}
+
+// Backward-shift deletion: walk the run after the hole and move back
+// every element whose home is at or before the hole, so no run gets
+// broken by it
+template<typename Key, typename Slot, typename Hash, typename Equal>
+bool swiss_table<Key, Slot, Hash, Equal>::erase(const Key& key){
+    if (sz == 0) return false;
+    std::size_t hole = index_of(key, mix(hash(key)));
+    if (hole == npos) return false;
+
+    slots[hole].~Slot();
+    for (std::size_t j=(hole + 1) & (cap - 1);ctrl[j]!=detail::empty;j=(j + 1) & (cap - 1)){
+        std::size_t h = home(mix(hash(detail::key_of(slots[j]))));
+        if (((j - h) & (cap - 1)) < ((j - hole) & (cap - 1))) continue;
+
+        ::new (slots + hole) Slot(std::move(slots[j]));
+        slots[j].~Slot();
+        set_ctrl(hole, ctrl[j]);
+        hole = j;
+    }
+    set_ctrl(hole, detail::empty);
+    --sz;
+    return true;
+}
+
+template<typename Key, typename Slot, typename Hash, typename Equal>
+void swiss_table<Key, Slot, Hash, Equal>::clear(){
+    if (sz == 0) return;
+    for (std::size_t i=0;i<cap;++i){
+        if (ctrl[i] != detail::empty) slots[i].~Slot();
+    }
+    std::memset(ctrl, detail::empty, cap + detail::group_width - 1);
+    sz = 0;
+}
+
+template<typename Key, typename Slot, typename Hash, typename Equal>
+void swiss_table<Key, Slot, Hash, Equal>::rehash(std::size_t new_cap){
+    std::unique_ptr<std::int8_t[]> new_ctrl{new std::int8_t[new_cap + detail::group_width - 1]};
+    std::memset(new_ctrl.get(), detail::empty, new_cap + detail::group_width - 1);
+    Slot* new_slots = static_cast<Slot*>(::operator new(new_cap * sizeof(Slot), std::align_val_t{alignof(Slot)}));
+
+    std::int8_t* old_ctrl = std::exchange(ctrl, new_ctrl.release());
+    Slot* old_slots = std::exchange(slots, new_slots);
+    std::size_t old_cap = std::exchange(cap, new_cap);
+
+    for (std::size_t i=0;i<old_cap;++i){
+        if (old_ctrl[i] == detail::empty) continue;
+        std::uint64_t h = mix(hash(detail::key_of(old_slots[i])));
+        std::size_t j = first_empty(h);
+        ::new (slots + j) Slot(std::move(old_slots[i]));
+        old_slots[i].~Slot();
+        set_ctrl(j, tag(h));
+    }
+
+    ::operator delete(old_slots, std::align_val_t{alignof(Slot)});
+    delete[] old_ctrl;
+}
+
+template<typename Key, typename Hash = hasher<Key>, typename Equal = key_equal<Key>>
+class hash_set : public swiss_table<Key, Key, Hash, Equal>{
+    using base = swiss_table<Key, Key, Hash, Equal>;
+
+    public:
+        using base::base;
+
+        bool insert(const Key& key){
+            return this->emplace(key, key).second;
+        }
+};
+
+template<typename Key, typename Value, typename Hash = hasher<Key>, typename Equal = key_equal<Key>>
+class hash_map : public swiss_table<Key, std::pair<const Key, Value>, Hash, Equal>{
+    using base = swiss_table<Key, std::pair<const Key, Value>, Hash, Equal>;
+
+    public:
+        using base::base;
+
+        bool insert(const Key& key, const Value& value){
+            return this->emplace(key, key, value).second;
+        }
+
+        Value& operator[](const Key& key){
+            return this->emplace(key, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple()).first->second;
+        }
+};
+
+template<typename Table>
+void bench_table(const char* name, const std::vector<data>& records, const std::vector<data>& probes, Table& table){
+    std::string prefix = name;
+    report(prefix + " insert", time_ms([&]{
+        table.clear();
+        for (const auto& d : records) table.insert(d);
+    }, 3));
+    report(prefix + " find", time_ms([&]{
+        std::size_t hits = 0;
+        for (const auto& d : probes) hits += table.find(d) != table.end();
+        do_not_optimize(hits);
+    }, 3));
+    report(prefix + " erase", time_ms([&]{
+        std::size_t erased = 0;
+        for (const auto& d : probes) erased += table.erase(d);
+        do_not_optimize(erased);
+    }, 1));
+}
+
+// hash_set::find returns a pointer, so adapt it to the std interface
+struct swiss_adapter{
+    hash_set<data>& table;
+
+    void clear(){ table.clear(); }
+    bool insert(const data& d){ return table.insert(d); }
+    const data* find(const data& d) const { return table.find(d); }
+    const data* end() const { return nullptr; }
+    bool erase(const data& d){ return table.erase(d); }
+};
+
+int main(){
+    hash_set<data> s;
+    for (int i=0;i<4;i++){
+        for (int j=2;j>0;j--) s.insert({i, j});
+    }
+    s.insert({1, 1});
+    std::cout << s.size() << ' ' << s.contains({1, 1}) << ' ' << s.erase({1, 1}) << ' ' << s.contains({1, 1}) << ' ' << s.size() << '\n';
+
+    hash_map<std::string, int> counts;
+    for (const char* w : {"a", "b", "a", "c", "a"}) ++counts[w];
+    std::cout << counts["a"] << ' ' << counts.size() << '\n';
+
+    // Against std::unordered_set through inserts and erases, so that
+    // backward shifts run over long clusters
+    std::mt19937 gen{42};
+    {
+        hash_set<data> table;
+        std::unordered_set<data, hasher<data>, key_equal<data>> reference;
+        for (int i=0;i<200000;++i){
+            data d{int(gen() % 5000), int(gen() % 4)};
+            if (gen() % 3 == 0){
+                if (table.erase(d) != (reference.erase(d) == 1)) throw std::logic_error{"erase disagrees"};
+            }
+            else if (table.insert(d) != reference.insert(d).second) throw std::logic_error{"insert disagrees"};
+        }
+        std::size_t found = 0;
+        for (const auto& d : reference) found += table.contains(d);
+        if (found != reference.size() || table.size() != reference.size()) throw std::logic_error{"contents differ"};
+    }
+
+    // Benchmark: a 2^20-slot table filled to each load factor, then as
+    // many lookups (half of them misses) and erases of those probes. The
+    // std containers get the same elements.
+    constexpr std::size_t slots = 1 << 20;
+    for (double load : {0.25, 0.5, 0.75, 0.85}){
+        std::size_t n = static_cast<std::size_t>(slots * load);
+        std::vector<data> records(n), probes(n);
+        for (auto& d : records) d = {int(gen()), int(gen())};
+        for (std::size_t i=0;i<n;++i) probes[i] = i % 2 ? records[gen() % n] : data{int(gen()), int(gen())};
+
+        hash_set<data> swiss;
+        swiss.reserve(slots - slots / 8);
+        std::cout << "\n" << n << " records, load factor " << load << '\n';
+
+        std::set<data, Functor> tree;
+        bench_table("std::set", records, probes, tree);
+
+        std::unordered_set<data, hasher<data>, key_equal<data>> unordered;
+        unordered.reserve(n);
+        bench_table("std::unordered_set", records, probes, unordered);
+
+        swiss_adapter adapter{swiss};
+        bench_table("hash_set", records, probes, adapter);
+        if (swiss.capacity() != slots) throw std::logic_error{"hash_set rehashed"};
+    }
+}
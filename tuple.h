@@ -0,0 +1,218 @@
+// Source: https://stackoverflow.com/questions/4041447/how-is-stdtuple-implemented
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Contains the actual value for one item in the tuple. The 
+// template parameter `i` allows the
+// `Get` function to find the value in O(1) time.
+// [[no_unique_address]] lets an empty Item (a stateless functor, a tag)
+// take no space, the same as the empty base optimization would
+template<std::size_t i, typename Item>
+struct TupleLeaf {
+    [[no_unique_address]] Item value;
+};
+
+// Recursive implementation: one level of inheritance per item.
+// TupleImpl is a proxy for the final class that has an extra
+// template parameter `i`.
+template<std::size_t i, typename... Items>
+struct TupleImpl;
+
+// Base case: empty tuple
+template<std::size_t i>
+struct TupleImpl<i>{};
+
+// Recursive specialization
+template<std::size_t i, typename HeadItem, typename... TailItems>
+struct TupleImpl<i, HeadItem, TailItems...> :
+    public TupleLeaf<i, HeadItem>, // This adds a `value` member of type HeadItem
+    public TupleImpl<i + 1, TailItems...> // This recurses
+    {};
+
+template<typename... Items>
+using RecursiveTuple = TupleImpl<0, Items...>;
+
+// Flat implementation: every leaf is a direct base, with the indices
+// coming from an index_sequence. There is no recursion, so a tuple of N
+// items costs one class instantiation instead of N nested ones whose
+// template argument lists add up to O(N^2), and wide tuples stay far from
+// the template depth limit.
+template<typename Indices, typename... Items>
+struct FlatTupleImpl;
+
+template<std::size_t... is, typename... Items>
+struct FlatTupleImpl<std::index_sequence<is...>, Items...> : public TupleLeaf<is, Items>... {};
+
+// Templated alias to avoid having to spell out the indices
+template<typename... Items>
+using Tuple = FlatTupleImpl<std::index_sequence_for<Items...>, Items...>;
+
+template<typename T>
+struct TupleSize;
+
+template<std::size_t... is, typename... Items>
+struct TupleSize<FlatTupleImpl<std::index_sequence<is...>, Items...>>
+    : std::integral_constant<std::size_t, sizeof...(Items)> {};
+
+template<std::size_t i, typename... Items>
+struct TupleSize<TupleImpl<i, Items...>>
+    : std::integral_constant<std::size_t, sizeof...(Items)> {};
+
+// Obtain a reference to i-th item in a tuple. Both implementations have
+// exactly one TupleLeaf base with index `i`, so the argument converts to
+// that base and `Item` is deduced from it: O(1), no recursion.
+template<std::size_t i, typename Item>
+Item& Get(TupleLeaf<i, Item>& leaf) {
+    return leaf.value;
+}
+
+template<std::size_t i, typename Item>
+const Item& Get(const TupleLeaf<i, Item>& leaf) {
+    return leaf.value;
+}
+
+// Obtain a reference to the item of type `Item`. Deduction fails (and
+// so does the call) if there is more than one.
+template<typename Item, std::size_t i>
+Item& Get(TupleLeaf<i, Item>& leaf) {
+    return leaf.value;
+}
+
+template<typename Item, std::size_t i>
+const Item& Get(const TupleLeaf<i, Item>& leaf) {
+    return leaf.value;
+}
+
+// Type of the i-th item, found through the one TupleLeaf base with index i
+template<std::size_t i, typename Item>
+std::type_identity<Item> LeafType(const TupleLeaf<i, Item>&);
+
+template<std::size_t i, typename... Items>
+using TupleElement = typename decltype(LeafType<i>(std::declval<const Tuple<Items...>&>()))::type;
+
+namespace detail
+{
+
+    template<std::size_t... is, typename... Items>
+    auto TieImpl(std::index_sequence<is...>, Items&... items) {
+        return FlatTupleImpl<std::index_sequence<is...>, Items&...>{TupleLeaf<is, Items&>{items}...};
+    }
+
+} // namespace detail
+
+// Builds a Tuple of references. Tuple is an aggregate of its leaves.
+template<typename... Items>
+auto Tie(Items&... items) {
+    return detail::TieImpl(std::index_sequence_for<Items...>{}, items...);
+}
+
+// f(Get<0>(tuple), Get<1>(tuple), ...)
+template<typename F, typename T>
+decltype(auto) Apply(F&& f, T&& tuple) {
+    return [&]<std::size_t... is>(std::index_sequence<is...>) -> decltype(auto) {
+        return std::forward<F>(f)(Get<is>(tuple)...);
+    }(std::make_index_sequence<TupleSize<std::remove_cvref_t<T>>::value>{});
+}
+
+// f(Get<i>(tuple)) for every i, in order
+template<typename T, typename F>
+void ForEach(T&& tuple, F&& f) {
+    [&]<std::size_t... is>(std::index_sequence<is...>) {
+        (f(Get<is>(tuple)), ...);
+    }(std::make_index_sequence<TupleSize<std::remove_cvref_t<T>>::value>{});
+}
+
+namespace detail
+{
+
+    template<std::size_t i, typename R, typename T, typename F>
+    R VisitItem(T& tuple, F& f) {
+        return f(Get<i>(tuple));
+    }
+
+} // namespace detail
+
+// f(Get<index>(tuple)) for an index only known at run time. The calls for
+// every index are put in a static table of function pointers, so this is
+// a bounds check and one indirect call, like a switch's jump table. f has
+// to return the same type (or void) for every item.
+template<typename T, typename F>
+decltype(auto) Visit(T& tuple, std::size_t index, F&& f) {
+    constexpr std::size_t n = TupleSize<std::remove_cv_t<T>>::value;
+    if (index >= n) throw std::out_of_range{"Visit: index out of range"};
+
+    return [&]<std::size_t... is>(std::index_sequence<is...>) -> decltype(auto) {
+        using R = std::common_type_t<decltype(f(Get<is>(tuple)))...>;
+        static constexpr R (*table[])(T&, std::remove_reference_t<F>&) = {
+            &detail::VisitItem<is, R, T, std::remove_reference_t<F>>...
+        };
+        return table[index](tuple, f);
+    }(std::make_index_sequence<n>{});
+}
+
+namespace detail
+{
+
+    // Item indices sorted by decreasing alignment (stable, so equally
+    // aligned items keep their order). Laying items out in this order
+    // leaves no padding between them, only at the end.
+    template<typename... Items>
+    constexpr std::array<std::size_t, sizeof...(Items)> AlignmentOrder() {
+        constexpr std::size_t n = sizeof...(Items);
+        std::array<std::size_t, n> align{alignof(Items)...};
+        std::array<std::size_t, n> order{};
+        for (std::size_t k = 0; k < n; ++k) order[k] = k;
+
+        for (std::size_t k = 1; k < n; ++k) {
+            for (std::size_t j = k; j > 0 && align[order[j - 1]] < align[order[j]]; --j) {
+                std::swap(order[j - 1], order[j]);
+            }
+        }
+        return order;
+    }
+
+    template<typename... Items>
+    constexpr std::array<std::size_t, sizeof...(Items)> InverseOrder() {
+        constexpr auto order = AlignmentOrder<Items...>();
+        std::array<std::size_t, sizeof...(Items)> slot{};
+        for (std::size_t k = 0; k < order.size(); ++k) slot[order[k]] = k;
+        return slot;
+    }
+
+    template<typename Seq, typename... Items>
+    struct PackedStorage;
+
+    template<std::size_t... ks, typename... Items>
+    struct PackedStorage<std::index_sequence<ks...>, Items...> {
+        static constexpr auto order = AlignmentOrder<Items...>();
+        using type = Tuple<TupleElement<order[ks], Items...>...>;
+    };
+
+} // namespace detail
+
+// Same items and the same Get<i> as Tuple<Items...>, but stored sorted by
+// alignment, so e.g. PackedTuple<char, int, char> is 8 bytes instead of
+// 12. Opt-in, since it changes the layout from the declaration order.
+template<typename... Items>
+struct PackedTuple {
+    // slot[i] is where the i-th item is physically stored
+    static constexpr auto slot = detail::InverseOrder<Items...>();
+
+    typename detail::PackedStorage<std::index_sequence_for<Items...>, Items...>::type storage;
+};
+
+template<std::size_t i, typename... Items>
+TupleElement<i, Items...>& Get(PackedTuple<Items...>& tuple) {
+    return Get<PackedTuple<Items...>::slot[i]>(tuple.storage);
+}
+
+template<std::size_t i, typename... Items>
+const TupleElement<i, Items...>& Get(const PackedTuple<Items...>& tuple) {
+    return Get<PackedTuple<Items...>::slot[i]>(tuple.storage);
+}
@@ -0,0 +1,42 @@
+// Compile-time benchmark for tuple.h, driven by tuple_compile_bench.sh.
+//
+// Instantiates COPIES distinct tuple types of N items each and reads every
+// item with Get<i>, using Tuple (flat) or RecursiveTuple depending on
+// whether RECURSIVE is defined.
+
+#include <cstddef>
+#include <utility>
+
+#include "tuple.h"
+
+#ifndef N
+#define N 10
+#endif
+
+#ifndef COPIES
+#define COPIES 10
+#endif
+
+template<std::size_t copy, std::size_t k>
+struct field {
+    int v;
+};
+
+template<std::size_t copy, std::size_t... ks>
+int sum_fields(std::index_sequence<ks...>) {
+#ifdef RECURSIVE
+    RecursiveTuple<field<copy, ks>...> tuple{};
+#else
+    Tuple<field<copy, ks>...> tuple{};
+#endif
+    return (Get<ks>(tuple).v + ... + 0);
+}
+
+template<std::size_t... copies>
+int sum_all(std::index_sequence<copies...>) {
+    return (sum_fields<copies>(std::make_index_sequence<N>{}) + ...);
+}
+
+int main() {
+    return sum_all(std::make_index_sequence<COPIES>{});
+}
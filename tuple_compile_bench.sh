@@ -0,0 +1,22 @@
+#!/bin/sh
+# Compile time of tuple_compile_bench.cpp for the flat and the recursive
+# Tuple, at several tuple widths.
+#
+# usage: ./tuple_compile_bench.sh [compiler]
+
+CXX=${1:-${CXX:-g++}}
+cd "$(dirname "$0")" || exit 1
+
+compile_time(){
+    start=$(date +%s.%N)
+    "$CXX" -std=c++20 -fsyntax-only -ftemplate-depth=2048 "$@" tuple_compile_bench.cpp || exit 1
+    end=$(date +%s.%N)
+    awk "BEGIN { print $end - $start }"
+}
+
+printf '%6s %12s %12s\n' N flat recursive
+for n in 10 50 200; do
+    flat=$(compile_time -DN=$n)
+    recursive=$(compile_time -DN=$n -DRECURSIVE)
+    printf '%6s %11.2fs %11.2fs\n' "$n" "$flat" "$recursive"
+done
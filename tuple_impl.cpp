@@ -1,42 +1,21 @@
-// Source: https://stackoverflow.com/questions/4041447/how-is-stdtuple-implemented
-
 #include <iostream>
+#include <string>
 
-// Contains the actual value for one item in the tuple. The 
-// template parameter `i` allows the
-// `Get` function to find the value in O(1) time
-template<std::size_t i, typename Item>
-struct TupleLeaf {
-    Item value;
-};
+#include "tuple.h"
 
-// TupleImpl is a proxy for the final class that has an extra 
-// template parameter `i`.
-template<std::size_t i, typename... Items>
-struct TupleImpl;
-
-// Base case: empty tuple
-template<std::size_t i>
-struct TupleImpl<i>{};
-
-// Recursive specialization
-template<std::size_t i, typename HeadItem, typename... TailItems>
-struct TupleImpl<i, HeadItem, TailItems...> :
-    public TupleLeaf<i, HeadItem>, // This adds a `value` member of type HeadItem
-    public TupleImpl<i + 1, TailItems...> // This recurses
-    {};
-
-// Obtain a reference to i-th item in a tuple
-template<std::size_t i, typename HeadItem, typename... TailItems>
-HeadItem& Get(TupleImpl<i, HeadItem, TailItems...>& tuple) {
-    // Fully qualified name for the member, to find the right one 
-    // (they are all called `value`).
-    return tuple.TupleLeaf<i, HeadItem>::value;
-}
+struct Empty {};
 
-// Templated alias to avoid having to specify `i = 0`
-template<typename... Items>
-using Tuple = TupleImpl<0, Items...>;
+// stateless comparator, takes no space in a Tuple
+struct Less {
+    bool operator()(int a, int b) const { return a < b; }
+};
+
+// same fields as classes B and F in class_sizes.cpp
+static_assert(sizeof(Tuple<int, Less>) == sizeof(int));
+static_assert(sizeof(Tuple<char, int, char>) == 12);
+static_assert(sizeof(PackedTuple<char, int, char>) == 8);
+static_assert(sizeof(Tuple<int, double, int>) == 24);
+static_assert(sizeof(PackedTuple<int, double, int>) == 16);
 
 int main(int argc, char** argv) {
     Tuple<int, float, std::string> tuple;
@@ -46,5 +25,39 @@ int main(int argc, char** argv) {
     std::cout << Get<0>(tuple) << std::endl;
     std::cout << Get<1>(tuple) << std::endl;
     std::cout << Get<2>(tuple) << std::endl;
+
+    // a Tuple of references writes through to the variables
+    int a = 1;
+    double b = 2.5;
+    auto refs = Tie(a, b);
+    Get<0>(refs) = 10;
+    Get<1>(refs) *= 2;
+    std::cout << a << ' ' << b << std::endl;
+
+    // Get<i> keeps the declared order, whatever the layout
+    PackedTuple<char, double, Empty, int> packed;
+    Get<0>(packed) = 'c';
+    Get<1>(packed) = 3.5;
+    Get<3>(packed) = 7;
+    std::cout << Get<0>(packed) << ' ' << Get<1>(packed) << ' ' << Get<3>(packed) << ' '
+              << sizeof(Tuple<char, double, Empty, int>) << ' ' << sizeof(packed) << std::endl;
+    // lookup by type, and calls over all items
+    Get<std::string>(tuple) += "Bar";
+    std::cout << Get<std::string>(tuple) << std::endl;
+    std::cout << Apply([](int i, float f, const std::string& s) { return i + f + s.size(); }, tuple) << std::endl;
+    ForEach(tuple, [](const auto& item) { std::cout << item << ' '; });
+    std::cout << std::endl;
+
+    // runtime index, dispatched through a table of function pointers
+    for (std::size_t i = 0; i < 3; ++i) {
+        Visit(tuple, i, [](auto& item) { std::cout << sizeof(item) << ' '; });
+    }
+    std::cout << std::endl;
+
+    // the recursive implementation is still there, with the same API
+    RecursiveTuple<int, char> recursive;
+    Get<0>(recursive) = 42;
+    Get<char>(recursive) = 'r';
+    std::cout << Get<0>(recursive) << ' ' << Get<1>(recursive) << std::endl;
     return 0;
-}
\ No newline at end of file
+}
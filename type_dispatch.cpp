@@ -0,0 +1,234 @@
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+#include <iostream>
+
+#include "bench.h"
+#include "type_name.h"
+
+namespace detail
+{
+
+    // slot(id) = (id * mult) >> (64 - bits), with mult chosen so that
+    // no two of the ids share a slot
+    struct perfect_hash{
+        std::uint64_t mult;
+        unsigned bits;
+
+        constexpr std::size_t operator()(std::uint64_t id) const {
+            return static_cast<std::size_t>((id * mult) >> (64 - bits));
+        }
+    };
+
+    template<std::size_t N>
+    constexpr bool collides(const std::array<std::uint64_t, N>& ids, perfect_hash h){
+        for (std::size_t i=0;i<N;++i){
+            for (std::size_t j=i+1;j<N;++j){
+                if (h(ids[i]) == h(ids[j])) return true;
+            }
+        }
+        return false;
+    }
+
+    // Tries random odd multipliers, starting with a table of at least
+    // 2N slots and doubling it whenever a few hundred of them all fail
+    template<std::size_t N>
+    constexpr perfect_hash find_perfect_hash(const std::array<std::uint64_t, N>& ids){
+        std::uint64_t seed = 0x9e3779b97f4a7c15;
+        for (unsigned bits = std::bit_width(N); bits < 32; ++bits){
+            for (int attempt=0;attempt<256;++attempt){
+                seed += 0x9e3779b97f4a7c15;
+                std::uint64_t z = seed;
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+
+                perfect_hash h{(z ^ (z >> 31)) | 1, bits};
+                if (!collides(ids, h)) return h;
+            }
+        }
+        throw std::logic_error{"no perfect hash: two types share an id"};
+    }
+
+} // namespace detail
+
+// Routes a type-erased object to the overload of Handler for its type,
+// given the object's type_id. The table from id to call is built at
+// compile time and keyed by a perfect hash, so a lookup is a multiply, a
+// shift, one compare and an indirect call, whatever the number of types.
+template<typename Handler, typename... Types>
+class type_dispatch{
+    public:
+        // Calls h(*static_cast<const T*>(object)) where T is the type
+        // with the given id. Returns false if T is none of Types.
+        static bool call(Handler& h, std::uint64_t id, const void* object){
+            const entry& e = table[hash(id)];
+            if (e.id != id || !e.call) return false;
+
+            e.call(h, object);
+            return true;
+        }
+
+        static constexpr std::size_t table_size(){
+            return table.size();
+        }
+
+    private:
+        using thunk = void (*)(Handler&, const void*);
+
+        struct entry{
+            std::uint64_t id = 0;
+            thunk call = nullptr;
+        };
+
+        template<typename T>
+        static void invoke(Handler& h, const void* object){
+            h(*static_cast<const T*>(object));
+        }
+
+        static constexpr std::array<std::uint64_t, sizeof...(Types)> ids{type_id<Types>()...};
+        static constexpr detail::perfect_hash hash = detail::find_perfect_hash(ids);
+
+        static constexpr std::array<entry, std::size_t{1} << hash.bits> table = []{
+            std::array<entry, std::size_t{1} << hash.bits> t{};
+            ((t[hash(type_id<Types>())] = {type_id<Types>(), &invoke<Types>}), ...);
+            return t;
+        }();
+};
+
+// Messages as they would arrive off a queue: a tag and a body. The base
+// class is only there for the RTTI versions below.
+struct message{
+    virtual ~message() = default;
+};
+
+struct login : message { int user; };
+struct logout : message { int user; };
+struct order_new : message { int id; int qty; };
+struct order_cancel : message { int id; };
+struct order_fill : message { int id; int qty; };
+struct heartbeat : message {};
+struct quote : message { int bid; int ask; };
+struct trade : message { int price; int qty; };
+
+struct envelope{
+    std::uint64_t type;
+    const std::type_info* info;
+    const message* body;
+};
+
+template<typename T>
+envelope wrap(const T& m){
+    return {type_id<T>(), &typeid(T), &m};
+}
+
+struct router{
+    long long total = 0;
+
+    void operator()(const login& m){ total += m.user; }
+    void operator()(const logout& m){ total -= m.user; }
+    void operator()(const order_new& m){ total += m.qty; }
+    void operator()(const order_cancel& m){ total -= m.id; }
+    void operator()(const order_fill& m){ total += m.id * m.qty; }
+    void operator()(const heartbeat&){ ++total; }
+    void operator()(const quote& m){ total += m.ask - m.bid; }
+    void operator()(const trade& m){ total += m.price * m.qty; }
+};
+
+using routes = type_dispatch<router, login, logout, order_new, order_cancel, order_fill, heartbeat, quote, trade>;
+
+// The same routing through RTTI: a type_index-keyed map...
+struct rtti_routes{
+    using thunk = void (*)(router&, const void*);
+    std::unordered_map<std::type_index, thunk> map;
+
+    template<typename T>
+    void add(){
+        map[typeid(T)] = [](router& r, const void* p){ r(*static_cast<const T*>(p)); };
+    }
+
+    rtti_routes(){
+        add<login>(); add<logout>(); add<order_new>(); add<order_cancel>();
+        add<order_fill>(); add<heartbeat>(); add<quote>(); add<trade>();
+    }
+
+    bool call(router& r, const envelope& e) const {
+        auto it = map.find(*e.info);
+        if (it == map.end()) return false;
+
+        it->second(r, e.body);
+        return true;
+    }
+};
+
+// ...and a dynamic_cast chain
+template<typename T, typename... Rest>
+bool cast_chain(router& r, const message* m){
+    if (auto p = dynamic_cast<const T*>(m)){
+        r(*p);
+        return true;
+    }
+    if constexpr (sizeof...(Rest) > 0) return cast_chain<Rest...>(r, m);
+    else return false;
+}
+
+int main(){
+    router r;
+    order_fill fill;
+    fill.id = 3;
+    fill.qty = 7;
+    envelope e = wrap(fill);
+    std::cout << routes::call(r, e.type, e.body) << ' ' << r.total << '\n';
+    std::cout << routes::call(r, type_id<int>(), nullptr) << '\n';
+    std::cout << "8 types in " << routes::table_size() << " slots\n";
+
+    // Benchmark: 4M messages of random types
+    constexpr std::size_t n = 1 << 22;
+    std::vector<std::unique_ptr<message>> owned;
+    std::vector<envelope> queue;
+    std::mt19937 gen{42};
+    for (std::size_t i=0;i<n;++i){
+        int k = static_cast<int>(gen() % 8);
+        auto add = [&]<typename T>(T m){
+            owned.push_back(std::make_unique<T>(m));
+            queue.push_back(wrap(static_cast<const T&>(*owned.back())));
+        };
+        switch (k){
+            case 0: { login m; m.user = k; add(m); break; }
+            case 1: { logout m; m.user = k; add(m); break; }
+            case 2: { order_new m; m.id = k; m.qty = 2; add(m); break; }
+            case 3: { order_cancel m; m.id = k; add(m); break; }
+            case 4: { order_fill m; m.id = k; m.qty = 3; add(m); break; }
+            case 5: { add(heartbeat{}); break; }
+            case 6: { quote m; m.bid = 1; m.ask = 2; add(m); break; }
+            default: { trade m; m.price = 5; m.qty = 4; add(m); break; }
+        }
+    }
+
+    rtti_routes rtti;
+    std::cout << "\n" << n << " messages, 8 types\n";
+    report("type_dispatch", time_ms([&]{
+        router r;
+        for (const auto& e : queue) routes::call(r, e.type, e.body);
+        do_not_optimize(r.total);
+    }));
+    report("unordered_map<type_index>", time_ms([&]{
+        router r;
+        for (const auto& e : queue) rtti.call(r, e);
+        do_not_optimize(r.total);
+    }));
+    report("dynamic_cast chain", time_ms([&]{
+        router r;
+        for (const auto& e : queue){
+            cast_chain<login, logout, order_new, order_cancel, order_fill, heartbeat, quote, trade>(r, e.body);
+        }
+        do_not_optimize(r.total);
+    }));
+}
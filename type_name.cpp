@@ -3,51 +3,7 @@
 #include <string_view>
 #include <iostream>
 
-template <typename T>
-constexpr std::string_view type_name();
-
-template <>
-constexpr std::string_view type_name<void>(){
-    return "void";
-}
-
-namespace detail
-{
-
-    using type_name_prober = void;
-
-    template <typename T>
-    constexpr std::string_view wrapped_type_name(){
-        
-#ifdef __clang__
-        return __PRETTY_FUNCTION__;
-#elif defined(__GNUC__)
-        return __PRETTY_FUNCTION__;
-#elif defined(_MSC_VER)
-        return __FUNCSIG__;
-#else
-#error "Unsupported compiler"
-#endif
-    }
-
-    constexpr std::size_t wrapped_type_name_prefix_length(){
-        return wrapped_type_name<type_name_prober>().find(type_name<type_name_prober>());
-    }
-
-    constexpr std::size_t wrapped_type_name_suffix_length(){
-        return wrapped_type_name<type_name_prober>().length() - wrapped_type_name_prefix_length() - type_name<type_name_prober>().length();
-    }
-
-} // namespace detail
-
-template <typename T>
-constexpr std::string_view type_name(){
-    constexpr auto wrapped_name = detail::wrapped_type_name<T>();
-    constexpr auto prefix_length = detail::wrapped_type_name_prefix_length();
-    constexpr auto suffix_length = detail::wrapped_type_name_suffix_length();
-    constexpr auto type_name_length = wrapped_name.length() - prefix_length - suffix_length;
-    return wrapped_name.substr(prefix_length, type_name_length);
-}
+#include "type_name.h"
 
 template<typename T, T v>
 void func(){
@@ -106,4 +62,7 @@ int main(){
               << type_name<decltype((goo().lvalref))>() << '\n'
               << type_name<decltype((goo().x))>() << '\n'
               << type_name<decltype((goo().y))>() << '\n';
+
+    static_assert(type_id<A>() != type_id<const A>());
+    std::cout << std::hex << type_id<A>() << ' ' << type_id<B>() << '\n';
 }
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+// Source: https://stackoverflow.com/questions/81870/is-it-possible-to-print-a-variables-type-in-standard-c/64490578#64490578
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+template <typename T>
+constexpr std::string_view type_name();
+
+template <>
+constexpr std::string_view type_name<void>(){
+    return "void";
+}
+
+namespace detail
+{
+
+    using type_name_prober = void;
+
+    template <typename T>
+    constexpr std::string_view wrapped_type_name(){
+        
+#ifdef __clang__
+        return __PRETTY_FUNCTION__;
+#elif defined(__GNUC__)
+        return __PRETTY_FUNCTION__;
+#elif defined(_MSC_VER)
+        return __FUNCSIG__;
+#else
+#error "Unsupported compiler"
+#endif
+    }
+
+    constexpr std::size_t wrapped_type_name_prefix_length(){
+        return wrapped_type_name<type_name_prober>().find(type_name<type_name_prober>());
+    }
+
+    constexpr std::size_t wrapped_type_name_suffix_length(){
+        return wrapped_type_name<type_name_prober>().length() - wrapped_type_name_prefix_length() - type_name<type_name_prober>().length();
+    }
+
+} // namespace detail
+
+template <typename T>
+constexpr std::string_view type_name(){
+    constexpr auto wrapped_name = detail::wrapped_type_name<T>();
+    constexpr auto prefix_length = detail::wrapped_type_name_prefix_length();
+    constexpr auto suffix_length = detail::wrapped_type_name_suffix_length();
+    constexpr auto type_name_length = wrapped_name.length() - prefix_length - suffix_length;
+    return wrapped_name.substr(prefix_length, type_name_length);
+}
+
+namespace detail
+{
+
+    constexpr std::uint64_t fnv1a(std::string_view s){
+        std::uint64_t h = 0xcbf29ce484222325;
+        for (char c : s){
+            h ^= static_cast<unsigned char>(c);
+            h *= 0x100000001b3;
+        }
+        return h;
+    }
+
+} // namespace detail
+
+// A 64-bit id for T, fixed at compile time: the FNV-1a hash of its name.
+// Ids are only stable for one compiler, since each spells names its own way.
+template <typename T>
+constexpr std::uint64_t type_id(){
+    constexpr std::uint64_t id = detail::fnv1a(type_name<T>());
+    return id;
+}
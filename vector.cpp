@@ -1,94 +1,16 @@
-#include <cstddef>
-#include <cstdlib>
-#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
 #include <iostream>
 
-template<typename T>
-class vector{
-    public:
-        vector(int n, T m = T{});
+#include "arena.h"
+#include "parallel.h"
+#include "vector.h"
 
-        void push_back(const T&);
-        void push_back(T&&);
-
-        void pop_back();
-
-        std::size_t size() const {
-            return sz;
-        }
-
-        std::size_t capacity() const {
-            return cap;
-        }
-
-        void print() const {
-            for (int i=0;i<sz;++i){
-                std::cout << *(p + i) << ' ';
-            }
-            std::cout << '\n';
-        }
-
-        ~vector();
-
-    private:
-        T* p;
-        std::size_t cap;
-        std::size_t sz;
-};
-
-template<typename T>
-vector<T>::vector(int n, T m)
-    : sz(n), cap(n)
-{
-    // allocating storage
-    p = static_cast<T*>(std::malloc(n * sizeof(T)));
-    
-    for (int i=0;i<n;++i){
-        new(p + i) T{m};
-    }
-}
-
-template<typename T>
-vector<T>::~vector(){
-    for (int i=0;i<sz;++i){
-        (p + i)->~T();
-    }
-
-    std::free(p);
-}
-
-template<typename T>
-void vector<T>::push_back(const T& x){
-    if (sz == cap){
-        cap *= 2;
-        p = static_cast<T*>(std::realloc(p, cap * sizeof(T)));
-    }
-
-    new(p + sz) T{x};
-    ++sz;
-}
-
-template<typename T>
-void vector<T>::push_back(T&& x){
-    if (sz == cap){
-        cap *= 2;
-        p = static_cast<T*>(std::realloc(p, cap * sizeof(T)));
-    }
-
-    new(p + sz) T{std::move(x)};
-    ++sz;
-}
-
-template<typename T>
-void vector<T>::pop_back(){
-    --sz;
-    (p + sz)->~T();
-
-    if (2 * sz < cap){
-        cap /= 2;
-        p = static_cast<T*>(std::realloc(p, cap * sizeof(T)));
-    }
-}
+static_assert(std::ranges::contiguous_range<vector<int>>);
 
 int main(){
     vector<int> v1{2};
@@ -111,4 +33,98 @@ int main(){
     
     v1.print();
     std::cout << v1.size() << ' ' << v1.capacity() << '\n';
-}
\ No newline at end of file
+
+    // an empty vector can grow, and capacity can be managed explicitly
+    vector<int> v0{0};
+    v0.push_back(7);
+    v0.reserve(100);
+    std::cout << v0.size() << ' ' << v0.capacity() << '\n';
+    v0.shrink_to_fit();
+    std::cout << v0.size() << ' ' << v0.capacity() << '\n';
+
+    // bulk construction
+    int batch[] = {10, 20, 30, 40};
+    vector<int> v4{0};
+    v4.append(std::begin(batch), std::end(batch));
+    v4.insert(1, std::begin(batch), std::begin(batch) + 2);
+    v4.print();
+    v4.resize(8);
+    v4.print();
+    v4.assign(3, 5);
+    v4.print();
+
+    // trivially copyable but not assignable: still fill-constructible
+    struct tagged{ const int id; };
+    vector<tagged> tags{3, tagged{7}};
+    std::cout << tags.size() << ' ' << tags[2].id << '\n';
+
+    // iterators, so the standard algorithms work directly
+    std::sort(v4.begin(), v4.end(), std::greater<>{});
+    std::span<int> s4 = v4;
+    std::cout << std::accumulate(s4.begin(), s4.end(), 0) << ' ' << v4[0] << ' ' << v4.data()[1] << '\n';
+    try {
+        v4.at(3);
+    }
+    catch (const std::out_of_range& e){
+        std::cout << "out of range: " << e.what() << '\n';
+    }
+
+    vector<double> big{0};
+    big.resize(1'000'000);
+    std::iota(big.begin(), big.end(), 0.0);
+    parallel::for_each(big, [](double& x){ x *= 2; });
+    std::cout << parallel::reduce(big, 0.0) << '\n';
+
+    // one vector in its own mapping, growing without copies
+    vector<long long> huge{0, 0, mapped_storage{.reserve_bytes = 1 << 20}};
+    for (int i=0;i<1'000'000;++i) huge.push_back(i);     // 8 MB, past the 1 MB reservation
+    std::cout << huge.size() << ' ' << huge.back() << ' '
+              << huge.region()->reserved() << ' ' << huge.region()->huge_pages_enabled() << '\n';
+
+    vector<std::string> mapped_strings{1, "mapped", mapped_storage{.reserve_bytes = 4096, .huge_pages = false}};
+    for (int i=0;i<1000;++i) mapped_strings.push_back(std::to_string(i));
+    std::cout << mapped_strings.size() << ' ' << mapped_strings[0] << ' ' << mapped_strings.back() << '\n';
+
+    // std::string may point into itself (SSO), so growing with a plain
+    // realloc would leave it dangling; it takes the move path instead
+    vector<std::string> v3{1, "short"};
+    v3.push_back("a string long enough to live on the heap");
+    v3.push_back("sso");
+    v3.push_back(std::string(40, 'x'));
+    v3.print();
+    std::cout << v3.size() << ' ' << v3.capacity() << '\n';
+
+    v3.emplace_back(5, 'y');
+    v3.print();
+
+    v3.pop_back();
+    v3.pop_back();
+    v3.print();
+    std::cout << v3.size() << ' ' << v3.capacity() << '\n';
+
+    // Request-scoped vectors: everything comes out of one arena, which is
+    // rewound after each request instead of freeing vector by vector
+    arena_resource arena{1024};
+    for (int request=0;request<3;++request){
+        {
+            vector<int> ids{1, request, &arena};
+            vector<std::string> names{1, "req", &arena};
+            for (int i=0;i<100;++i){
+                ids.push_back(i);
+                names.push_back(std::to_string(i));
+            }
+            std::cout << "request " << request << ": " << ids.size() << " ids, "
+                      << names.size() << " names\n";
+        }
+
+        std::cout << "arena reserved " << arena.reserved() << " bytes\n";
+        arena.reset();
+    }
+
+    // An odd-sized block leaves the chunk end unaligned; the next aligned
+    // request must go to a new chunk, not past the end
+    arena_resource odd{64};
+    (void)odd.allocate(1001, 1);
+    void* p = odd.allocate(8, 8);
+    std::cout << "aligned " << (reinterpret_cast<std::uintptr_t>(p) % 8 == 0) << ", arena reserved " << odd.reserved() << " bytes\n";
+}
@@ -0,0 +1,652 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <iostream>
+
+#include "mapped_region.h"
+
+// A type is trivially relocatable if moving an object to a new address and
+// forgetting the old one is the same as a memcpy. Trivially copyable types
+// always are; specialize this for other types known to be safe (e.g. a type
+// that only holds a unique_ptr).
+template<typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template<typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+namespace detail
+{
+
+    enum class relocation { bitwise, move, copy };
+
+    // Picked at compile time: memcpy when it is valid, move when it can't
+    // throw (or when there is nothing else to do), copy otherwise so that
+    // a throwing copy leaves the source untouched
+    template<typename T>
+    constexpr relocation relocation_strategy(){
+        if constexpr (is_trivially_relocatable_v<T>)
+            return relocation::bitwise;
+        else if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+            return relocation::move;
+        else
+            return relocation::copy;
+    }
+
+    // Relocates `n` objects from `src` into the uninitialized storage at `dst`
+    // and ends the lifetime of the objects in `src`. If constructing in `dst`
+    // throws, `dst` is cleaned up and `src` is left as it was.
+    template<typename T>
+    void relocate(T* src, std::size_t n, T* dst){
+        constexpr auto strategy = relocation_strategy<T>();
+
+        if constexpr (strategy == relocation::bitwise){
+            if (n) std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+        }
+        else if constexpr (strategy == relocation::move){
+            std::uninitialized_move_n(src, n, dst);
+            std::destroy_n(src, n);
+        }
+        else {
+            std::uninitialized_copy_n(src, n, dst);
+            std::destroy_n(src, n);
+        }
+    }
+
+    // Bulk construction kernels used by the range and fill APIs. For
+    // trivially copyable T they are plain memcpy / std::fill_n, which the
+    // compiler lowers to memset or a vectorized broadcast; anything else
+    // is constructed element by element (and cleaned up if one throws).
+    // fill_n assigns, so it also needs T to be assignable (a const member
+    // leaves a type trivially copyable but not assignable).
+    template<typename T>
+    void fill_construct(T* dst, std::size_t n, const T& value){
+        if constexpr (std::is_trivially_copyable_v<T> && std::is_trivially_copy_assignable_v<T>)
+            std::fill_n(dst, n, value);
+        else
+            std::uninitialized_fill_n(dst, n, value);
+    }
+
+    template<typename T>
+    void value_construct(T* dst, std::size_t n){
+        if constexpr (std::is_trivially_copyable_v<T> && std::is_trivially_copy_assignable_v<T> &&
+                      std::is_trivially_default_constructible_v<T>)
+            std::fill_n(dst, n, T());
+        else
+            std::uninitialized_value_construct_n(dst, n);
+    }
+
+    template<typename It, typename T>
+    void copy_construct(It first, std::size_t n, T* dst){
+        if constexpr (std::contiguous_iterator<It> &&
+                      std::is_same_v<std::iter_value_t<It>, T> &&
+                      std::is_trivially_copyable_v<T>){
+            if (n) std::memcpy(static_cast<void*>(dst), static_cast<const void*>(std::to_address(first)), n * sizeof(T));
+        }
+        else
+            std::uninitialized_copy_n(first, n, dst);
+    }
+
+} // namespace detail
+
+// Tag for the resize overload that leaves new trivial elements uninitialized
+struct default_init_t{
+    explicit default_init_t() = default;
+};
+
+inline constexpr default_init_t default_init{};
+
+// A full vector grows by a factor of Num/Den; one that drops below
+// 1/ShrinkAt occupancy shrinks by the same factor. Shrinking well below
+// the point where it would grow again is what stops a push/pop pattern
+// around a boundary from reallocating on every call: with the default
+// (grow at full, shrink at a quarter) every operation is amortized O(1).
+template<std::size_t Num = 2, std::size_t Den = 1, std::size_t ShrinkAt = 4>
+struct geometric_growth{
+    static_assert(Num > Den, "capacity must actually grow");
+    static_assert(ShrinkAt * Den >= Num, "shrinking must not drop below the size");
+
+    // Capacity to move to when a vector of capacity `cap` is full
+    static constexpr std::size_t grow(std::size_t cap){
+        return std::max(cap + 1, cap * Num / Den);
+    }
+
+    // Capacity to move to once `sz` elements are left, `cap` to keep it
+    static constexpr std::size_t shrink(std::size_t sz, std::size_t cap){
+        if (sz * ShrinkAt >= cap) return cap;
+        return cap * Den / Num;
+    }
+};
+
+using default_growth_policy = geometric_growth<>;
+
+// Asks a vector to live in its own mmap'd region instead of the heap.
+// Meant for vectors of hundreds of MB: growth within the reservation is
+// free, growth past it is an mremap, and scans can use huge pages.
+struct mapped_storage{
+    std::size_t reserve_bytes = std::size_t{1} << 30;   // address space, not memory
+    bool huge_pages = true;
+};
+
+// Storage comes from std::malloc unless a memory_resource is given, in
+// which case every allocation goes through it (e.g. an arena_resource
+// shared by all the vectors built while serving one request). Only the
+// malloc path can grow with realloc. With mapped_storage the vector
+// owns a mapped_region and grows it in place.
+template<typename T, typename GrowthPolicy = default_growth_policy>
+class vector{
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using reference = T&;
+        using const_reference = const T&;
+
+        // Elements are contiguous, so plain pointers are already
+        // contiguous iterators and every standard algorithm works
+        using iterator = T*;
+        using const_iterator = const T*;
+
+        vector(int n, T m = T{}, std::pmr::memory_resource* r = nullptr);
+        vector(int n, T m, mapped_storage storage);
+
+        void push_back(const T&);
+        void push_back(T&&);
+
+        template<typename... Args>
+        T& emplace_back(Args&&... args);
+
+        void pop_back();
+
+        // Appends [first, last). Forward ranges reserve once up front and
+        // are copied in bulk. The range must not come from this vector.
+        template<std::input_iterator It>
+        void append(It first, It last);
+
+        // Inserts [first, last) before index `pos`, same rules as append
+        template<std::input_iterator It>
+        void insert(std::size_t pos, It first, It last);
+
+        // Grows with value-initialized elements (zeroes for int), or
+        // shrinks. Capacity is kept when shrinking.
+        void resize(std::size_t n);
+
+        // Same, but new elements are default-initialized, so trivial
+        // types are left as they are in memory
+        void resize(std::size_t n, default_init_t);
+
+        void resize(std::size_t n, const T& value);
+
+        // Replaces the contents
+        void assign(std::size_t n, const T& value);
+
+        template<std::input_iterator It>
+        void assign(It first, It last);
+
+        // Destroys all elements, keeps the capacity
+        void clear();
+
+        // Makes room for at least `n` elements
+        void reserve(std::size_t n);
+
+        // Gives back all unused capacity
+        void shrink_to_fit();
+
+        std::size_t size() const {
+            return sz;
+        }
+
+        std::size_t capacity() const {
+            return cap;
+        }
+
+        std::pmr::memory_resource* resource() const {
+            return res;
+        }
+
+        const mapped_region* region() const {
+            return mapped.get();
+        }
+
+        bool empty() const {
+            return sz == 0;
+        }
+
+        T* data(){
+            return p;
+        }
+
+        const T* data() const {
+            return p;
+        }
+
+        iterator begin(){
+            return p;
+        }
+
+        iterator end(){
+            return p + sz;
+        }
+
+        const_iterator begin() const {
+            return p;
+        }
+
+        const_iterator end() const {
+            return p + sz;
+        }
+
+        const_iterator cbegin() const {
+            return p;
+        }
+
+        const_iterator cend() const {
+            return p + sz;
+        }
+
+        // Unchecked access
+        T& operator[](std::size_t i){
+            return p[i];
+        }
+
+        const T& operator[](std::size_t i) const {
+            return p[i];
+        }
+
+        // Checked access, throws std::out_of_range
+        T& at(std::size_t i);
+        const T& at(std::size_t i) const;
+
+        T& front(){
+            return p[0];
+        }
+
+        T& back(){
+            return p[sz - 1];
+        }
+
+        operator std::span<T>(){
+            return {p, sz};
+        }
+
+        operator std::span<const T>() const {
+            return {p, sz};
+        }
+
+        void print() const {
+            for (std::size_t i=0;i<sz;++i){
+                std::cout << *(p + i) << ' ';
+            }
+            std::cout << '\n';
+        }
+
+        ~vector();
+
+    private:
+        T* allocate(std::size_t n);
+        void deallocate(T* q, std::size_t n);
+
+        void reallocate(std::size_t new_cap);
+        void remap(std::size_t new_cap);
+
+        // Makes room for `extra` more elements, at least as much as the
+        // growth policy would give so repeated appends stay amortized O(1)
+        void reserve_extra(std::size_t extra);
+
+        template<typename... Args>
+        void realloc_append(Args&&... args);
+
+        T* p;
+        std::size_t cap;
+        std::size_t sz;
+        std::pmr::memory_resource* res;
+        std::unique_ptr<mapped_region> mapped;
+};
+
+template<typename T, typename GrowthPolicy>
+vector<T, GrowthPolicy>::vector(int n, T m, std::pmr::memory_resource* r)
+    : cap(n), sz(n), res(r)
+{
+    // allocating storage
+    p = allocate(n);
+
+    try {
+        detail::fill_construct(p, n, m);
+    }
+    catch (...){
+        deallocate(p, n);
+        throw;
+    }
+}
+
+template<typename T, typename GrowthPolicy>
+vector<T, GrowthPolicy>::vector(int n, T m, mapped_storage storage)
+    : p(nullptr), cap(0), sz(0), res(nullptr),
+      mapped(std::make_unique<mapped_region>(std::max(storage.reserve_bytes, n * sizeof(T)), storage.huge_pages))
+{
+    p = reinterpret_cast<T*>(mapped->data());
+    remap(n);
+
+    detail::fill_construct(p, n, m);
+    sz = n;
+}
+
+template<typename T, typename GrowthPolicy>
+vector<T, GrowthPolicy>::~vector(){
+    std::destroy_n(p, sz);
+    deallocate(p, cap);
+}
+
+template<typename T, typename GrowthPolicy>
+T* vector<T, GrowthPolicy>::allocate(std::size_t n){
+    if (n == 0) return nullptr;
+
+    if (res) return static_cast<T*>(res->allocate(n * sizeof(T), alignof(T)));
+
+    T* q = static_cast<T*>(std::malloc(n * sizeof(T)));
+    if (!q) throw std::bad_alloc{};
+    return q;
+}
+
+template<typename T, typename GrowthPolicy>
+void vector<T, GrowthPolicy>::deallocate(T* q, std::size_t n){
+    if (!q || mapped) return;
+
+    if (res) res->deallocate(q, n * sizeof(T), alignof(T));
+    else std::free(q);
+}
+
+// Moves the elements into a buffer of `new_cap` elements. realloc is only
+// used when T is trivially relocatable, since it moves the bytes behind our
+// back; everything else goes through detail::relocate.
+template<typename T, typename GrowthPolicy>
+void vector<T, GrowthPolicy>::reallocate(std::size_t new_cap){
+    if (mapped){
+        remap(new_cap);
+        return;
+    }
+
+    if (new_cap == 0){
+        deallocate(p, cap);
+        p = nullptr;
+        cap = 0;
+        return;
+    }
+
+    if constexpr (is_trivially_relocatable_v<T>){
+        if (!res){
+            T* q = static_cast<T*>(std::realloc(p, new_cap * sizeof(T)));
+            if (!q) throw std::bad_alloc{};
+            p = q;
+            cap = new_cap;
+            return;
+        }
+    }
+
+    T* q = allocate(new_cap);
+
+    try {
+        detail::relocate(p, sz, q);
+    }
+    catch (...){
+        deallocate(q, new_cap);
+        throw;
+    }
+
+    deallocate(p, cap);
+    p = q;
+    cap = new_cap;
+}
+
+// Mapped storage: growing commits more of the region, moving it with
+// mremap only when T can be moved bitwise; otherwise the elements are
+// relocated into a fresh, bigger region. Shrinking hands pages back.
+template<typename T, typename GrowthPolicy>
+void vector<T, GrowthPolicy>::remap(std::size_t new_cap){
+    std::size_t bytes = new_cap * sizeof(T);
+
+    if (new_cap < cap){
+        mapped->decommit(bytes);
+    }
+    else if (!mapped->commit(bytes, is_trivially_relocatable_v<T>)){
+        auto fresh = std::make_unique<mapped_region>(std::max(bytes, mapped->reserved() * 2), mapped->huge_pages_requested());
+        fresh->commit(bytes, false);
+        detail::relocate(p, sz, reinterpret_cast<T*>(fresh->data()));
+        mapped = std::move(fresh);
+    }
+
+    p = reinterpret_cast<T*>(mapped->data());
+    cap = new_cap;
+}
+
+// Slow path of push_back. `args` may refer to an element of this vector, so
+// the new element is built before the old buffer goes away.
+template<typename T, typename GrowthPolicy>
+template<typename... Args>
+void vector<T, GrowthPolicy>::realloc_append(Args&&... args){
+    std::size_t new_cap = GrowthPolicy::grow(cap);
+
+    // these grow in place (or at least not through a second buffer we
+    // control), so `args` must be copied out before growing
+    if (mapped || (is_trivially_relocatable_v<T> && !res)){
+        T tmp(std::forward<Args>(args)...);
+        reallocate(new_cap);
+        new(p + sz) T(std::move(tmp));
+        ++sz;
+        return;
+    }
+
+    T* q = allocate(new_cap);
+
+    try {
+        new(q + sz) T(std::forward<Args>(args)...);
+    }
+    catch (...){
+        deallocate(q, new_cap);
+        throw;
+    }
+
+    try {
+        detail::relocate(p, sz, q);
+    }
+    catch (...){
+        (q + sz)->~T();
+        deallocate(q, new_cap);
+        throw;
+    }
+
+    deallocate(p, cap);
+    p = q;
+    cap = new_cap;
+    ++sz;
+}
+
+template<typename T, typename GrowthPolicy>
+void vector<T, GrowthPolicy>::push_back(const T& x){
+    emplace_back(x);
+}
+
+template<typename T, typename GrowthPolicy>
+void vector<T, GrowthPolicy>::push_back(T&& x){
+    emplace_back(std::move(x));
+}
+
+template<typename T, typename GrowthPolicy>
+template<typename... Args>
+T& vector<T, GrowthPolicy>::emplace_back(Args&&... args){
+    if (sz == cap){
+        realloc_append(std::forward<Args>(args)...);
+    }
+    else {
+        new(p + sz) T(std::forward<Args>(args)...);
+        ++sz;
+    }
+
+    return *(p + sz - 1);
+}
+
+template<typename T, typename GrowthPolicy>
+void vector<T, GrowthPolicy>::pop_back(){
+    --sz;
+    (p + sz)->~T();
+
+    std::size_t new_cap = GrowthPolicy::shrink(sz, cap);
+    if (new_cap != cap){
+        reallocate(new_cap);
+    }
+}
+
+template<typename T, typename GrowthPolicy>
+void vector<T, GrowthPolicy>::reserve(std::size_t n){
+    if (n > cap){
+        reallocate(n);
+    }
+}
+
+template<typename T, typename GrowthPolicy>
+void vector<T, GrowthPolicy>::shrink_to_fit(){
+    if (sz < cap){
+        reallocate(sz);
+    }
+}
+
+template<typename T, typename GrowthPolicy>
+void vector<T, GrowthPolicy>::reserve_extra(std::size_t extra){
+    if (sz + extra > cap){
+        reallocate(std::max(sz + extra, GrowthPolicy::grow(cap)));
+    }
+}
+
+template<typename T, typename GrowthPolicy>
+template<std::input_iterator It>
+void vector<T, GrowthPolicy>::append(It first, It last){
+    if constexpr (std::forward_iterator<It>){
+        auto n = static_cast<std::size_t>(std::distance(first, last));
+        reserve_extra(n);
+        detail::copy_construct(first, n, p + sz);
+        sz += n;
+    }
+    else {
+        for (;first!=last;++first){
+            emplace_back(*first);
+        }
+    }
+}
+
+// New elements are built at the end and then rotated into place; for
+// trivially relocatable T the tail is simply memmove'd out of the way
+template<typename T, typename GrowthPolicy>
+template<std::input_iterator It>
+void vector<T, GrowthPolicy>::insert(std::size_t pos, It first, It last){
+    std::size_t old_sz = sz;
+
+    if constexpr (std::forward_iterator<It> && is_trivially_relocatable_v<T>){
+        auto n = static_cast<std::size_t>(std::distance(first, last));
+        reserve_extra(n);
+
+        T* at = p + pos;
+        if (pos < old_sz) std::memmove(static_cast<void*>(at + n), static_cast<const void*>(at), (old_sz - pos) * sizeof(T));
+
+        try {
+            detail::copy_construct(first, n, at);
+        }
+        catch (...){
+            if (pos < old_sz) std::memmove(static_cast<void*>(at), static_cast<const void*>(at + n), (old_sz - pos) * sizeof(T));
+            throw;
+        }
+        sz += n;
+    }
+    else {
+        append(first, last);
+        std::rotate(p + pos, p + old_sz, p + sz);
+    }
+}
+
+template<typename T, typename GrowthPolicy>
+void vector<T, GrowthPolicy>::resize(std::size_t n){
+    if (n <= sz){
+        std::destroy(p + n, p + sz);
+        sz = n;
+        return;
+    }
+
+    reserve(n);
+    detail::value_construct(p + sz, n - sz);
+    sz = n;
+}
+
+template<typename T, typename GrowthPolicy>
+void vector<T, GrowthPolicy>::resize(std::size_t n, default_init_t){
+    if (n <= sz){
+        std::destroy(p + n, p + sz);
+        sz = n;
+        return;
+    }
+
+    reserve(n);
+    std::uninitialized_default_construct_n(p + sz, n - sz);
+    sz = n;
+}
+
+template<typename T, typename GrowthPolicy>
+void vector<T, GrowthPolicy>::resize(std::size_t n, const T& value){
+    if (n <= sz){
+        std::destroy(p + n, p + sz);
+        sz = n;
+        return;
+    }
+
+    if (n > cap){
+        T tmp(value);   // value may be one of our elements
+        reserve(n);
+        detail::fill_construct(p + sz, n - sz, tmp);
+    }
+    else {
+        detail::fill_construct(p + sz, n - sz, value);
+    }
+    sz = n;
+}
+
+template<typename T, typename GrowthPolicy>
+void vector<T, GrowthPolicy>::assign(std::size_t n, const T& value){
+    T tmp(value);
+    clear();
+    reserve(n);
+    detail::fill_construct(p, n, tmp);
+    sz = n;
+}
+
+template<typename T, typename GrowthPolicy>
+template<std::input_iterator It>
+void vector<T, GrowthPolicy>::assign(It first, It last){
+    clear();
+    append(first, last);
+}
+
+template<typename T, typename GrowthPolicy>
+void vector<T, GrowthPolicy>::clear(){
+    std::destroy_n(p, sz);
+    sz = 0;
+}
+
+template<typename T, typename GrowthPolicy>
+T& vector<T, GrowthPolicy>::at(std::size_t i){
+    if (i >= sz) throw std::out_of_range{"vector::at"};
+    return p[i];
+}
+
+template<typename T, typename GrowthPolicy>
+const T& vector<T, GrowthPolicy>::at(std::size_t i) const {
+    if (i >= sz) throw std::out_of_range{"vector::at"};
+    return p[i];
+}
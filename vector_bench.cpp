@@ -0,0 +1,116 @@
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "bench.h"
+#include "parallel.h"
+#include "vector.h"
+
+// The policy vector used to have: double when full, halve as soon as
+// less than half is used. Growing and shrinking at the same point means
+// a size that wobbles around a power of two reallocates every time.
+using eager_growth = geometric_growth<2, 1, 2>;
+
+// Fills a vector up to just below a capacity boundary, then goes back and
+// forth across it: +2 elements, -2 elements, `cycles` times
+template<typename T, typename Policy>
+double bench_oscillation(std::size_t boundary, int cycles, const T& value){
+    return time_ms([&]{
+        vector<T, Policy> v{1, value};
+        while (v.size() < boundary - 1) v.push_back(value);
+
+        for (int c=0;c<cycles;++c){
+            v.push_back(value);
+            v.push_back(value);
+            v.pop_back();
+            v.pop_back();
+        }
+        do_not_optimize(v.capacity());
+    }, 3);
+}
+
+struct record{
+    int id;
+    float value;
+    long long timestamp;
+};
+
+// Ingests `batches` batches of records into a vector that already has
+// the capacity, either one push_back at a time or with one append per
+// batch, so only the per-element overhead is measured
+template<bool bulk>
+double bench_ingest(const std::vector<record>& batch, int batches){
+    vector<record> v{0};
+    v.reserve(batch.size() * batches);
+
+    return time_ms([&]{
+        v.clear();
+        for (int b=0;b<batches;++b){
+            if constexpr (bulk){
+                v.append(batch.begin(), batch.end());
+            }
+            else {
+                for (const auto& r : batch) v.push_back(r);
+            }
+        }
+        do_not_optimize(v.size());
+    });
+}
+
+// Grows a vector of `n` ints one push_back at a time, then sums it
+template<typename Vector>
+void bench_large(const char* name, std::size_t n, Vector v){
+    report((std::string(name) + " push_back").c_str(), time_ms([&]{
+        v.clear();
+        v.shrink_to_fit();
+        for (std::size_t i=0;i<n;++i) v.push_back(int(i));
+    }, 3));
+    report((std::string(name) + " scan").c_str(), time_ms([&]{
+        do_not_optimize(std::accumulate(v.begin(), v.end(), 0LL));
+    }));
+}
+
+int main(){
+    constexpr std::size_t boundary = 1 << 14;
+    constexpr int cycles = 20'000;
+
+    std::cout << "push/pop across a capacity boundary of " << boundary << " elements\n";
+    report("int, eager shrink", bench_oscillation<int, eager_growth>(boundary, cycles, 1));
+    report("int, default policy", bench_oscillation<int, default_growth_policy>(boundary, cycles, 1));
+
+    std::string s(32, 'x');
+    report("std::string, eager shrink", bench_oscillation<std::string, eager_growth>(boundary, cycles, s));
+    report("std::string, default policy", bench_oscillation<std::string, default_growth_policy>(boundary, cycles, s));
+
+    std::vector<record> batch(4096);
+    for (std::size_t i=0;i<batch.size();++i) batch[i] = {int(i), float(i), (long long)i};
+
+    std::cout << "\ningest 64 batches of " << batch.size() << " records\n";
+    report("push_back per record", bench_ingest<false>(batch, 64));
+    report("append per batch", bench_ingest<true>(batch, 64));
+
+    std::cout << "\nresize to 16M ints\n";
+    report("resize (value-init)", time_ms([]{ vector<int> v{0}; v.resize(1 << 24); do_not_optimize(v.size()); }));
+    report("resize (default-init)", time_ms([]{ vector<int> v{0}; v.resize(1 << 24, default_init); do_not_optimize(v.size()); }));
+
+    vector<double> xs{0};
+    xs.resize(1 << 24);
+    std::iota(xs.begin(), xs.end(), 0.0);
+    vector<double> ys{0};
+    ys.resize(xs.size(), default_init);
+
+    std::cout << "\n16M doubles, " << parallel::thread_pool::global().size() << " threads\n";
+    report("std::transform sqrt", time_ms([&]{ std::transform(xs.begin(), xs.end(), ys.begin(), [](double x){ return std::sqrt(x); }); }));
+    report("parallel::transform sqrt", time_ms([&]{ parallel::transform(xs, ys, [](double x){ return std::sqrt(x); }); }));
+    report("std::accumulate", time_ms([&]{ do_not_optimize(std::accumulate(xs.begin(), xs.end(), 0.0)); }));
+    report("parallel::reduce", time_ms([&]{ do_not_optimize(parallel::reduce(xs, 0.0)); }));
+
+    constexpr std::size_t large = std::size_t{1} << 27;
+    std::cout << "\n" << (large * sizeof(int) >> 20) << " MB of ints\n";
+    bench_large("heap", large, vector<int>{0});
+    bench_large("mapped, 4K pages", large, vector<int>{0, 0, mapped_storage{.huge_pages = false}});
+    bench_large("mapped, huge pages", large, vector<int>{0, 0, mapped_storage{}});
+}